@@ -0,0 +1,99 @@
+//asset archive. all the assets in one file made by PackAssets, the file is
+//mapped in memory and every asset is used from there without reading it.
+//
+//file format, little endian:
+//  header    "TPAK" version count alignment          16 bytes
+//  index     count entries                           80 bytes each
+//  blobs     the files, each one starts at a multiple of alignment
+#ifndef ASSETARCHIVE_H
+#define ASSETARCHIVE_H
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "MappedFile.h"
+
+const unsigned int archiveversion = 1;
+const unsigned int archivealignment = 64;
+const std::string assetarchivefile = "assets.pak";  //the game uses it instead of the loose files if it's there
+
+struct ArchiveHeader{
+    char magic[4];
+    unsigned int version;
+    unsigned int count;
+    unsigned int alignment;
+};
+
+//the strings are the fields of the line in assets.txt, ended with zeros
+struct ArchiveEntry{
+    char datatype[4];
+    char name[44];
+    char options[16];
+    unsigned long long offset;  //from the start of the file
+    unsigned long long size;
+};
+
+static_assert(sizeof(ArchiveHeader) == 16, "the archive header is 16 bytes");
+static_assert(sizeof(ArchiveEntry) == 80, "an archive entry is 80 bytes");
+
+class AssetArchive
+{
+public:
+    AssetArchive() { count = 0; };
+
+    //general methods
+    bool Open(const std::string &filename);
+    void Close() { file.Close(); count = 0; };
+
+    //accessor methods
+    bool IsOpen() { return file.IsOpen(); };
+    int GetCount() { return count; };
+    const ArchiveEntry &GetEntry(int i) { return ((const ArchiveEntry*)(file.GetData() + sizeof(ArchiveHeader)))[i]; };
+    const unsigned char *GetData(int i) { return file.GetData() + GetEntry(i).offset; };
+
+private:
+    MappedFile file;
+    int count;
+};
+
+bool AssetArchive::Open(const std::string &filename)
+{
+    Close();
+    //the assets are read in any order, some of them all the time
+    if( !file.Open(filename, false) ) return false;
+
+    //the header and the index must be right, the blobs are checked by whoever uses them
+    ArchiveHeader h;
+    size_t size = file.GetSize();
+    if( size < sizeof(h) )
+    {
+        std::cout << "Error " << filename << " is not an asset archive" << std::endl;
+        Close();
+        return false;
+    }
+    std::memcpy(&h, file.GetData(), sizeof(h));
+    if( std::memcmp(h.magic, "TPAK", 4) != 0 || h.version != archiveversion ||
+        sizeof(h) + (unsigned long long)h.count * sizeof(ArchiveEntry) > size )
+    {
+        std::cout << "Error " << filename << " is not an asset archive" << std::endl;
+        Close();
+        return false;
+    }
+
+    count = h.count;
+    for(int i=0;i<count;i++)
+    {
+        const ArchiveEntry &e = GetEntry(i);
+        if( e.offset > size || e.size > size - e.offset ||
+            e.datatype[sizeof(e.datatype)-1] != 0 || e.name[sizeof(e.name)-1] != 0 || e.options[sizeof(e.options)-1] != 0 )
+        {
+            std::cout << "Error " << filename << " is damaged" << std::endl;
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
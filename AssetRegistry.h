@@ -0,0 +1,90 @@
+//asset registry. every asset name gets a number the first time it's seen and
+//the assets are kept in a vector by that number. the game asks for the
+//handle of a name once and uses it after that, so drawing a texture or
+//playing a sound doesn't make, compare or search any string, and a name
+//that was never loaded doesn't add an empty asset.
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//the number of an asset in the table of its type, a texture handle can't be used for a sound
+template<class T> struct AssetHandle{
+    int id;
+
+    AssetHandle() : id(-1) {};
+    explicit AssetHandle(int pid) : id(pid) {};
+    bool IsValid() const { return id >= 0; };
+    bool operator==(const AssetHandle &h) const { return id == h.id; };
+    bool operator!=(const AssetHandle &h) const { return id != h.id; };
+};
+
+//the assets of one type. the handles stay valid when the assets are removed,
+//they are the same when the assets are loaded again
+template<class T> class AssetTable
+{
+public:
+    typedef AssetHandle<T> Handle;
+
+    //general methods
+    Handle Intern(const std::string &name);  //a new handle the first time
+    Handle Find(const std::string &name) const;  //not valid if the name was never seen
+    T &Create(Handle h);  //the asset of the handle, a new empty one if it isn't loaded
+    void Remove(Handle h) { if( h.id >= 0 && h.id < (int)items.size() ) items[h.id].reset(); };
+    void Clear();  //removes all the assets, keeps the names
+
+    //accessor methods
+    T *Get(Handle h) { return (h.id >= 0 && h.id < (int)items.size()) ? items[h.id].get() : nullptr; };  //null if not loaded
+    bool IsLoaded(Handle h) { return Get(h) != nullptr; };
+    const std::string &GetName(Handle h) { return names[h.id]; };
+    int GetCount() { return names.size(); };
+    bool IsEmpty();  //nothing is loaded
+
+private:
+    std::map<std::string, int> ids;
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<T>> items;  //in the heap, the sprites and sounds keep pointers to them
+};
+
+template<class T> AssetHandle<T> AssetTable<T>::Intern(const std::string &name)
+{
+    std::map<std::string, int>::iterator it = ids.find(name);
+    if( it != ids.end() ) return Handle(it->second);
+
+    int id = names.size();
+    ids.insert(std::make_pair(name, id));
+    names.push_back(name);
+    items.push_back(std::unique_ptr<T>());
+    return Handle(id);
+}
+
+template<class T> AssetHandle<T> AssetTable<T>::Find(const std::string &name) const
+{
+    std::map<std::string, int>::const_iterator it = ids.find(name);
+    if( it == ids.end() ) return Handle();
+    return Handle(it->second);
+}
+
+template<class T> T &AssetTable<T>::Create(Handle h)
+{
+    //an asset loaded again is loaded in the same object, what points to it stays valid
+    if( !items[h.id] ) items[h.id].reset(new T());
+    return *items[h.id];
+}
+
+template<class T> void AssetTable<T>::Clear()
+{
+    for(size_t i=0;i<items.size();i++) items[i].reset();
+}
+
+template<class T> bool AssetTable<T>::IsEmpty()
+{
+    for(size_t i=0;i<items.size();i++)
+        if( items[i] ) return false;
+    return true;
+}
+
+#endif
@@ -0,0 +1,171 @@
+//texture atlas. the small images are packed in a few big textures when the
+//assets are loaded, so drawing them doesn't change the texture every time
+//and they can go in the same vertex array. every image is then a region:
+//a texture and the rectangle of the image in it.
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+const int atlaspagesize = 1024;
+const int atlaspadding = 1;  //empty pixels between images, so they don't bleed into each other
+
+struct TextureRegion{
+    const sf::Texture *texture;
+    sf::IntRect rect;
+};
+
+//skyline bottom-left packer: the used part of the page is kept as the
+//outline of its top, a list of horizontal segments, and every rectangle
+//goes where its top ends lowest
+class SkylinePacker
+{
+public:
+    SkylinePacker(int pwidth = atlaspagesize, int pheight = atlaspagesize) { Reset(pwidth, pheight); };
+
+    //general methods
+    void Reset(int pwidth, int pheight);
+    bool Insert(int w, int h, sf::Vector2i &pos);  //false if it doesn't fit
+
+private:
+    struct Segment{
+        int x, y, width;
+    };
+    std::vector<Segment> skyline;
+    int width, height;
+
+    int Fits(size_t i, int w, int h);  //y where the rectangle goes at segment i, -1 if it doesn't fit
+};
+
+void SkylinePacker::Reset(int pwidth, int pheight)
+{
+    width = pwidth;
+    height = pheight;
+    skyline.clear();
+    skyline.push_back(Segment{0, 0, width});
+}
+
+int SkylinePacker::Fits(size_t i, int w, int h)
+{
+    int x = skyline[i].x;
+    if( x + w > width ) return -1;
+
+    //it rests on the highest segment under it
+    int y = 0;
+    int left = w;
+    for( ; left > 0; i++ )
+    {
+        y = std::max(y, skyline[i].y);
+        if( y + h > height ) return -1;
+        left -= skyline[i].width;
+    }
+    return y;
+}
+
+bool SkylinePacker::Insert(int w, int h, sf::Vector2i &pos)
+{
+    int besty = height, bestwidth = width;
+    size_t best = skyline.size();
+    for(size_t i=0;i<skyline.size();i++)
+    {
+        int y = Fits(i, w, h);
+        if( y < 0 ) continue;
+        if( y + h < besty || (y + h == besty && skyline[i].width < bestwidth) )
+        {
+            best = i;
+            besty = y + h;
+            bestwidth = skyline[i].width;
+        }
+    }
+    if( best == skyline.size() ) return false;
+
+    pos = sf::Vector2i(skyline[best].x, besty - h);
+
+    //the new segment and what's left of the ones it covers
+    Segment s{pos.x, besty, w};
+    skyline.insert(skyline.begin() + best, s);
+    for(size_t i=best+1;i<skyline.size();)
+    {
+        int end = s.x + s.width;
+        if( skyline[i].x >= end ) break;
+        int shrink = end - skyline[i].x;
+        if( shrink < skyline[i].width )
+        {
+            skyline[i].x += shrink;
+            skyline[i].width -= shrink;
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+    }
+
+    //joins the segments at the same height
+    for(size_t i=0;i+1<skyline.size();)
+    {
+        if( skyline[i].y == skyline[i+1].y )
+        {
+            skyline[i].width += skyline[i+1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else i++;
+    }
+    return true;
+}
+
+//an image waiting to be packed
+struct AtlasImage{
+    std::string name;
+    sf::Image image;
+};
+
+//packs the images in pages, the tallest first. returns the images of the pages
+//and the rectangle of every image (in the order of images) and its page
+std::vector<sf::Image> PackAtlas(const std::vector<const AtlasImage*> &images, std::vector<sf::IntRect> &rects, std::vector<int> &pages)
+{
+    std::vector<size_t> order(images.size());
+    for(size_t i=0;i<order.size();i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        return images[a]->image.getSize().y > images[b]->image.getSize().y;
+    });
+
+    rects.assign(images.size(), sf::IntRect());
+    pages.assign(images.size(), -1);
+
+    std::vector<sf::Image> pageImages;
+    std::vector<SkylinePacker> packers;
+    for(size_t k=0;k<order.size();k++)
+    {
+        size_t i = order[k];
+        sf::Vector2u size = images[i]->image.getSize();
+        int w = size.x + atlaspadding, h = size.y + atlaspadding;
+        if( w > atlaspagesize || h > atlaspagesize )
+        {
+            std::cout << "Error " << images[i]->name << " is too big for the atlas" << std::endl;
+            continue;
+        }
+
+        //first page where it fits, or a new one
+        sf::Vector2i pos;
+        size_t p = 0;
+        while( p < packers.size() && !packers[p].Insert(w, h, pos) ) p++;
+        if( p == packers.size() )
+        {
+            packers.push_back(SkylinePacker());
+            packers[p].Insert(w, h, pos);
+            pageImages.push_back(sf::Image());
+            pageImages[p].create(atlaspagesize, atlaspagesize, sf::Color::Transparent);
+        }
+
+        pageImages[p].copy(images[i]->image, pos.x, pos.y);
+        rects[i] = sf::IntRect(pos.x, pos.y, size.x, size.y);
+        pages[i] = p;
+    }
+    return pageImages;
+}
+
+#endif
@@ -1,36 +1,51 @@
+//the backgrounds keep what they draw between frames: the textures are shared
+//with the assets, not copied, and the stars are points in a vertex buffer
+//where only the colors change.
 class Background{
 protected:
     int width, height;
     bool solid = false;
     sf::Color color;
-    sf::Texture texture;
+    const sf::Texture *texture = nullptr;
+    sf::IntRect rect;  //of the image in the texture
+    sf::Sprite sprite;
 
 public:
     Background(int pwidth, int pheight, sf::Color pcolor);
-    Background(sf::Texture ptexture);
+    Background(const TextureRegion &pregion);  //the texture must live as long as the background
     virtual ~Background();
 
     //general methods
     virtual void Update();
-    virtual void Draw(sf::RenderWindow &window);
+    virtual void Draw(sf::RenderTarget &target);
 
     //accessor methods
     int getWidth() { return width; };
     int getHeight() { return height; };
 };
 
-// horizontal scrolling background
+// horizontal scrolling background, with layers at different speeds for parallax.
+// every layer is a band of the same texture, so all of them are drawn at once
 class ScrollingBackground : Background{
 public:
-    int speed;
-    sf::IntRect bgRect;
-
-    ScrollingBackground(const std::string &stexture, int width, int height, float fspeed);
+    struct ScrollLayer{
+        sf::IntRect source;  //the band of the image
+        float y;             //where it's drawn
+        float speed;         //pixels per update
+        float offset;
+    };
+    std::vector<ScrollLayer> layers;
+
+    ScrollingBackground(TextureHandle texture, int width, int height, float fspeed);
     virtual ~ScrollingBackground();
 
     //general methods
+    void AddLayer(const sf::IntRect &source, float y, float fspeed);
     virtual void Update();
-    virtual void Draw(sf::RenderWindow &window);
+    virtual void Draw(sf::RenderTarget &target);
+
+protected:
+    sf::VertexArray vertices;  //2 quads per layer, the part until the end of the band and the part from the start
 };
 
 // starry background class
@@ -38,8 +53,10 @@ class StarryBackground : Background{
 protected:
     int numStars;
     int twinkleDelay;
-    sf::Vector2i ptStars[100];
-    sf::Color starColors[100];
+    sf::VertexArray stars;  //the points, their colors are changed in place
+    sf::VertexBuffer buffer;  //the same points in video memory, if the driver has them
+    bool useBuffer;
+    bool changed;  //the colors have to go to the buffer
 
 public:
     StarryBackground(int pwidth, int pheight, int pnumStars = 100, int ptwinkleDelay = 50);
@@ -47,7 +64,7 @@ public:
 
     //general methods
     virtual void Update();
-    virtual void Draw(sf::RenderWindow &window);
+    virtual void Draw(sf::RenderTarget &target);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -61,13 +78,17 @@ Background::Background(int pwidth, int pheight, sf::Color pcolor)
     solid = true;
 }
 
-Background::Background(sf::Texture ptexture)
+Background::Background(const TextureRegion &pregion)
 {
     color = sf::Color::Black;
-    texture = ptexture;
+    texture = pregion.texture;
+    rect = pregion.rect;
     solid = false;
-    width = ptexture.getSize().x;
-    height = ptexture.getSize().y;
+    width = rect.width;
+    height = rect.height;
+    if( texture != nullptr ) sprite.setTexture(*texture);
+    sprite.setTextureRect(rect);
+    sprite.setPosition(0,0);
 }
 
 Background::~Background()
@@ -80,36 +101,45 @@ void Background::Update()
     //do nothing since the basic background is not animated
 }
 
-void Background::Draw(sf::RenderWindow &window)
+void Background::Draw(sf::RenderTarget &target)
 {
     //draw the background if there is one
     if( !solid )
     {
-        sf::Sprite sp;
-        sp.setTexture(texture);
-        sp.setPosition(0,0);
-        window.draw(sp);
+        target.draw(sprite);
     }
     else
     {
-        window.clear(color);
+        target.clear(color);
     }
 }
 
 //starrybackground constructor
 StarryBackground::StarryBackground(int pwidth, int pheight, int pnumStars, int ptwinkleDelay) : Background(pwidth, pheight, sf::Color::Black)
 {
-    numStars = std::min(pnumStars, 100);
+    numStars = std::max(pnumStars, 0);
     twinkleDelay = ptwinkleDelay;
 
     //create the stars
+    stars.setPrimitiveType(sf::Points);
+    stars.resize(numStars);
     for (int i=0;i<numStars;i++)
     {
-        ptStars[i].x = rnd.getRndInt(0,width);
-        ptStars[i].y = rnd.getRndInt(0,height);
-        sf::Color c(128,128,128,255);
-        starColors[i] = c;
+        //the center of the pixel, so every star is exactly one pixel
+        stars[i].position = sf::Vector2f(rnd.getRndInt(0,width-1) + 0.5f, rnd.getRndInt(0,height-1) + 0.5f);
+        stars[i].color = sf::Color(128,128,128,255);
     }
+
+    //the positions never change, the colors are sent again when they do.
+    //without stars there is nothing to send
+    useBuffer = numStars > 0 && sf::VertexBuffer::isAvailable();
+    if( useBuffer )
+    {
+        buffer.setPrimitiveType(sf::Points);
+        buffer.setUsage(sf::VertexBuffer::Stream);
+        useBuffer = buffer.create(numStars) && buffer.update(&stars[0]);
+    }
+    changed = false;
 }
 
 StarryBackground::~StarryBackground()
@@ -126,62 +156,84 @@ void StarryBackground::Update()
         if( rnd.getRndInt(0,twinkleDelay) == 0 )
         {
             rgb = rnd.getRndInt(0,255);
-            sf::Color c(rgb,rgb,rgb,255);
-            starColors[i] = c;
+            stars[i].color = sf::Color(rgb,rgb,rgb,255);
+            changed = true;
         }
     }
 }
 
-void StarryBackground::Draw(sf::RenderWindow &window)
+void StarryBackground::Draw(sf::RenderTarget &target)
 {
     //draw the solid black background
-    window.clear(sf::Color::Black);
-
-    // Create a image filled with black color
-    sf::Image image;
-    image.create(width, height, sf::Color::Black);
+    target.clear(sf::Color::Black);
+    if( numStars == 0 ) return;
 
-    //Draw the stars in the image
-    for(int i=0;i<numStars;i++)
+    if( useBuffer )
     {
-        image.setPixel(ptStars[i].x, ptStars[i].y, starColors[i]);
+        if( changed ) buffer.update(&stars[0]);
+        changed = false;
+        target.draw(buffer);
     }
+    else target.draw(stars);
+}
 
-    //create a texture with the image
-    sf::Texture tx;
-    tx.create(width,height); //texture needs to be created first.
-    tx.update(image);
+ScrollingBackground::ScrollingBackground(TextureHandle texture, int width, int height, float fspeed)
+    : Background(mRegions.IsLoaded(texture) ? *mRegions.Get(texture) : TextureRegion{nullptr, sf::IntRect()})
+{
+    vertices.setPrimitiveType(sf::Quads);
 
-    //display it through sprite
-    sf::Sprite sp;
-    sp.setTexture(tx);
-    sp.setPosition(0,0);
-    window.draw(sp);
+    //the whole image is the first layer
+    AddLayer(sf::IntRect(0,0,width,height), 0, fspeed);
 }
 
-ScrollingBackground::ScrollingBackground(const std::string &stexture, int width, int height, float fspeed) : Background(mTextures[stexture])
+ScrollingBackground::~ScrollingBackground()
 {
-    speed = fspeed;
-    bgRect = sf::IntRect(0,0,width,height);
-    texture.setRepeated(true);
 }
 
-ScrollingBackground::~ScrollingBackground()
+void ScrollingBackground::AddLayer(const sf::IntRect &source, float y, float fspeed)
 {
+    ScrollLayer l;
+    l.source = source;
+    l.y = y;
+    l.speed = fspeed;
+    l.offset = 0;
+    layers.push_back(l);
+    vertices.resize(layers.size() * 8);
 }
 
 void ScrollingBackground::Update()
 {
-    bgRect.left += speed;
-    if( bgRect.left >= width ) bgRect.left = 0;
+    for(size_t i=0;i<layers.size();i++)
+    {
+        ScrollLayer &l = layers[i];
+        l.offset += l.speed;
+        if( l.offset >= l.source.width ) l.offset -= l.source.width;
+        if( l.offset < 0 ) l.offset += l.source.width;
+    }
 }
 
-void ScrollingBackground::Draw(sf::RenderWindow &window)
+void ScrollingBackground::Draw(sf::RenderTarget &target)
 {
-    sf::Sprite background;
-    background.setTexture(texture);
-    background.setTextureRect(bgRect);
-    background.setPosition(0,0);
-    window.draw(background);
-}
+    //every layer goes from its offset to the end of the band and then starts again,
+    //the bands can't use texture repeat because they are only part of the texture
+    for(size_t i=0;i<layers.size();i++)
+    {
+        const ScrollLayer &l = layers[i];
+        float tx = rect.left + l.source.left, ty = rect.top + l.source.top;
+        float w = l.source.width, h = l.source.height;
+        float first = w - l.offset;  //width of the first part
+
+        sf::Vertex *quad = &vertices[i * 8];
+        quad[0] = sf::Vertex(sf::Vector2f(0, l.y), sf::Vector2f(tx + l.offset, ty));
+        quad[1] = sf::Vertex(sf::Vector2f(first, l.y), sf::Vector2f(tx + w, ty));
+        quad[2] = sf::Vertex(sf::Vector2f(first, l.y + h), sf::Vector2f(tx + w, ty + h));
+        quad[3] = sf::Vertex(sf::Vector2f(0, l.y + h), sf::Vector2f(tx + l.offset, ty + h));
+
+        quad[4] = sf::Vertex(sf::Vector2f(first, l.y), sf::Vector2f(tx, ty));
+        quad[5] = sf::Vertex(sf::Vector2f(w, l.y), sf::Vector2f(tx + l.offset, ty));
+        quad[6] = sf::Vertex(sf::Vector2f(w, l.y + h), sf::Vector2f(tx + l.offset, ty + h));
+        quad[7] = sf::Vertex(sf::Vector2f(first, l.y + h), sf::Vector2f(tx, ty + h));
+    }
 
+    target.draw(vertices, sf::RenderStates(texture));
+}
@@ -0,0 +1,201 @@
+//batch simulator. plays many independent games on all the cores, without a
+//window, and prints the aggregate stats.
+//
+//usage: BatchSim [-n games] [-t threads] [-s seed] [-p maxpieces] [-b] [-i inputsfile] [-r replay]...
+//  -n  number of games (default 1000)
+//  -t  number of threads (default all the cores)
+//  -s  seed of the games, game i plays the pieces of (seed, i) (default 1)
+//  -p  stop a game after this many pieces (default 1000, 0 means no limit)
+//  -b  7-bag pieces
+//  -i  play the inputs recorded in a file (one byte per step) instead of the bot
+//  -r  play a replay file with the current rules, it can be given many times.
+//      only the replays are played, -n, -s, -p, -b and -i are ignored.
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "GameState.h"
+#include "Bot.h"
+#include "ThreadPool.h"
+#include "CacheLine.h"
+#include "Replay.h"
+
+//stats of the games played by one worker
+struct SimStats{
+    long long games = 0;
+    long long steps = 0;
+    long long pieces = 0;
+    long long lines = 0;
+    long long score = 0;
+    int maxscore = 0;
+
+    void Add(const SimStats &o)
+    {
+        games += o.games;
+        steps += o.steps;
+        pieces += o.pieces;
+        lines += o.lines;
+        score += o.score;
+        maxscore = std::max(maxscore, o.maxscore);
+    }
+};
+
+//everything a worker needs to play games, one per thread
+struct SimWorker{
+    GameState game;
+    Bot bot;
+    SimStats stats;
+};
+
+void AddGameStats(SimStats &stats, const GameState &g, long long steps)
+{
+    stats.games++;
+    stats.steps += steps;
+    stats.pieces += g.pieces;
+    stats.lines += g.lines;
+    stats.score += g.score;
+    stats.maxscore = std::max(stats.maxscore, g.score);
+}
+
+void PlayGame(SimWorker &w, uint64 seed, uint64 gameid, bool bag, int maxpieces, const std::vector<unsigned char> &inputs)
+{
+    GameState &g = w.game;
+    g.bag = bag;
+    g.NewGame(seed, gameid);
+    w.bot.Reset();
+
+    long long steps = 0;
+    while( !g.over )
+    {
+        if( maxpieces > 0 && g.pieces >= maxpieces ) break;
+
+        unsigned int input;
+        if( inputs.empty() ) input = w.bot.GetInput(g);
+        else if( steps < (long long)inputs.size() ) input = inputs[steps];
+        else break;
+
+        g.Step(input);
+        steps++;
+    }
+
+    AddGameStats(w.stats, g, steps);
+}
+
+//plays a replay as fast as possible, returns false if it can't be read
+bool PlayReplay(SimWorker &w, const std::string &filename)
+{
+    ReplayReader replay;
+    if( !replay.Open(filename) ) return false;
+
+    GameState &g = w.game;
+    g.bag = replay.bag;
+    g.NewGame(replay.seed, replay.gameid);
+
+    long long steps = 0;
+    unsigned int input;
+    while( !g.over && replay.Next(input) )
+    {
+        g.Step(input);
+        steps++;
+    }
+
+    AddGameStats(w.stats, g, steps);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    long long numgames = 1000;
+    int numthreads = 0;
+    uint64 seed = 1;
+    int maxpieces = 1000;
+    bool bag = false;
+    std::string inputsfile;
+    std::vector<std::string> replays;
+
+    for(int i=1;i<argc;i++)
+    {
+        std::string arg = argv[i];
+        if( arg == "-b" )
+        {
+            bag = true;
+            continue;
+        }
+        if( i + 1 >= argc )
+        {
+            std::cout << "Missing value for " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+        if( arg == "-n" ) numgames = std::atoll(argv[++i]);
+        else if( arg == "-t" ) numthreads = std::atoi(argv[++i]);
+        else if( arg == "-s" ) seed = std::strtoull(argv[++i], nullptr, 10);
+        else if( arg == "-p" ) maxpieces = std::atoi(argv[++i]);
+        else if( arg == "-i" ) inputsfile = argv[++i];
+        else if( arg == "-r" ) replays.push_back(argv[++i]);
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<unsigned char> inputs;
+    if( !inputsfile.empty() )
+    {
+        std::ifstream in(inputsfile, std::ios::binary);
+        if( !in.good() )
+        {
+            std::cout << "Error loading " << inputsfile << std::endl;
+            return EXIT_FAILURE;
+        }
+        inputs.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    ThreadPool pool(numthreads);
+    std::vector<CacheLinePadded<SimWorker>> workers(pool.GetNumThreads());  //they don't share cache lines
+
+    auto start = std::chrono::steady_clock::now();
+
+    //the games are given in small batches so the idle workers can steal them
+    const long long batch = 16;
+    for(size_t i=0;i<replays.size();i++)
+    {
+        pool.Submit([&, i](int worker)
+        {
+            if( !PlayReplay(workers[worker].value, replays[i]) )
+                std::cout << "Error loading " + replays[i] + "\n";
+        });
+    }
+    for(long long first=0;first<numgames && replays.empty();first+=batch)
+    {
+        long long last = std::min(first + batch, numgames);
+        pool.Submit([&, first, last](int worker)
+        {
+            for(long long i=first;i<last;i++)
+                PlayGame(workers[worker].value, seed, i, bag, maxpieces, inputs);
+        });
+    }
+    pool.Wait();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    SimStats total;
+    for(size_t i=0;i<workers.size();i++) total.Add(workers[i].value.stats);
+
+    std::cout << "threads     " << workers.size() << std::endl;
+    std::cout << "games       " << total.games << std::endl;
+    std::cout << "steps       " << total.steps << std::endl;
+    std::cout << "pieces      " << total.pieces << std::endl;
+    std::cout << "lines       " << total.lines << std::endl;
+    std::cout << "score       " << total.score << std::endl;
+    std::cout << "mean score  " << (total.games ? (double)total.score / total.games : 0) << std::endl;
+    std::cout << "max score   " << total.maxscore << std::endl;
+    std::cout << "seconds     " << seconds << std::endl;
+    std::cout << "games/sec   " << (seconds > 0 ? total.games / seconds : 0) << std::endl;
+    std::cout << "steps/sec   " << (seconds > 0 ? total.steps / seconds : 0) << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,378 @@
+//micro benchmarks of the hot paths of the game. it prints the time and the
+//heap allocations per call of every benchmark. run it from the folder with
+//the assets, like the game.
+//
+//usage: Bench [filter]   only runs the benchmarks with filter in their name
+#define TETRIS_NO_MAIN
+#include "Main.cpp"
+
+#include <atomic>
+#include <iomanip>
+#include <new>
+
+//every allocation of the program is counted. the replacements are not inlined
+//so the compiler doesn't pair the malloc/free inside them with new/delete.
+std::atomic<long long> allocations(0);
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if( void *p = std::malloc(size ? size : 1) ) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+//keeps the compiler from removing a result that is not used
+template<class T> inline void Keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+std::string filter;
+
+template<class F> void Run(const std::string &name, long long iterations, F f)
+{
+    if( !filter.empty() && name.find(filter) == std::string::npos ) return;
+
+    f(); //warm up
+
+    long long allocs = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for(long long i=0;i<iterations;i++) f();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    allocs = allocations - allocs;
+
+    std::cout << std::left << std::setw(44) << name << std::right
+              << std::setw(12) << iterations
+              << std::setw(14) << std::fixed << std::setprecision(1) << ns / iterations
+              << std::setw(12) << std::setprecision(2) << (double)allocs / iterations << std::endl;
+}
+
+//-----------------------------------------------------------------
+// Board fixtures, the same boards on every run
+//-----------------------------------------------------------------
+void FillRow(GameState &g, int row, unsigned int bits)
+{
+    g.rows[boardtop + row] = emptyrow | ((bits & ((1 << boardwidth) - 1)) << wallbits);
+    for(int j=0;j<boardwidth;j++)
+        g.colors[row][j] = (bits & (1 << j)) ? 1 + j % 7 : 0;
+}
+
+//the bottom half used, with a few holes
+GameState HalfBoard()
+{
+    GameState g;
+    g.NewGame(1);
+    for(int i=boardheight/2;i<boardheight;i++)
+        FillRow(g, i, ~(1u << (Squares32(i, 12345) % boardwidth)) & ~(Squares32(i + 100, 12345) & 0x21));
+    return g;
+}
+
+//15 rows of garbage, one gap per row and random noise on top
+GameState GarbageBoard()
+{
+    GameState g;
+    g.NewGame(2);
+    for(int i=5;i<boardheight;i++)
+    {
+        unsigned int bits = ~(1u << RandomBelow(Squares32(i, 999), boardwidth));
+        if( i < 8 ) bits &= Squares32(i + 50, 999);
+        FillRow(g, i, bits);
+    }
+    return g;
+}
+
+//4 full rows at the bottom but the first column, for an I piece to clear
+GameState TetrisBoard()
+{
+    GameState g;
+    g.NewGame(3);
+    for(int i=boardheight-4;i<boardheight;i++) FillRow(g, i, ~1u);
+    for(int i=boardheight/2;i<boardheight-4;i++) FillRow(g, i, 0x3C);
+    return g;
+}
+
+int main(int argc, char *argv[])
+{
+    if( argc > 1 ) filter = argv[1];
+
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(12) << "calls"
+              << std::setw(14) << "ns/op" << std::setw(12) << "allocs/op" << std::endl;
+
+    GameState fixtures[3] = { GameState(), HalfBoard(), GarbageBoard() };
+    const char *names[3] = { "empty", "half", "garbage" };
+
+    //every piece in every rotation in a few places near the top of the stack
+    std::vector<Piece> candidates;
+    for(int n=0;n<7;n++)
+        for(int r=0;r<4;r++)
+            for(int x=0;x<boardwidth;x++)
+                candidates.push_back(Piece{n, r, x, boardheight/2 - 1});
+
+    //-------------------------------------------------------------
+    // game rules
+    //-------------------------------------------------------------
+    for(int f=0;f<3;f++)
+    {
+        const GameState &g = fixtures[f];
+        size_t c = 0;
+        Run(std::string("valid (") + names[f] + ")", 10000000, [&]
+        {
+            Keep(g.Valid(candidates[c]));
+            if( ++c == candidates.size() ) c = 0;
+        });
+    }
+
+    for(int f=0;f<3;f++)
+    {
+        GameState g = fixtures[f];
+        g.piece = Piece{3, 0, boardwidth/2, 2};
+        Run(std::string("rotate (") + names[f] + ")", 10000000, [&]
+        {
+            Keep(g.Rotate());
+        });
+    }
+
+    GameState tetris = TetrisBoard();
+    Piece ipiece = Piece{0, 0, 0, boardheight-3};
+    Run("board copy", 1000000, [&]
+    {
+        GameState g = tetris;
+        Keep(g);
+    });
+    Run("lock + clear 4 lines (with board copy)", 1000000, [&]
+    {
+        GameState g = tetris;
+        g.Lock(ipiece, 1);
+        g.ClearLines(ipiece.y + shapes[0][0].top, shapes[0][0].height);
+        Keep(g);
+    });
+
+    for(int f=0;f<3;f++)
+    {
+        const GameState &g = fixtures[f];
+        BoardFeatures bf;
+        Run(std::string("board features simd (") + names[f] + ")", 1000000, [&]
+        {
+            GetBoardFeatures(g.rows, bf);
+            Keep(bf);
+        });
+        Run(std::string("board features scalar (") + names[f] + ")", 1000000, [&]
+        {
+            GetBoardFeaturesScalar(g.rows, bf);
+            Keep(bf);
+        });
+    }
+
+    for(int f=0;f<3;f++)
+    {
+        const GameState &g = fixtures[f];
+        Bot b;
+        Run(std::string("bot plan (") + names[f] + ")", 100000, [&]
+        {
+            b.Plan(g);
+            Keep(b.target);
+        });
+    }
+
+    {
+        InputQueue q;
+        sf::Time t = sf::Time::Zero;
+        Run("InputQueue Push + Tick", 1000000, [&]
+        {
+            q.Push(IN_LEFT, true, t);
+            q.Push(IN_LEFT, false, t + sf::milliseconds(5));
+            t += sf::milliseconds(33);
+            Keep(q.Tick(t, t));
+        });
+    }
+
+    {
+        SpscRing<KeyStroke, 256> ring;
+        KeyStroke stroke{sf::Keyboard::Left, true, sf::Time::Zero};
+        Run("SpscRing Push + Pop", 10000000, [&]
+        {
+            ring.Push(stroke);
+            ring.Pop(stroke);
+            Keep(stroke.down);
+        });
+    }
+
+    {
+        std::vector<int> scores(5, 0);
+        int sc = 0;
+        Run("UpdateHiScores", 1000000, [&]
+        {
+            UpdateHiScores(scores, sc);
+            sc += 40;
+        });
+    }
+
+    //-------------------------------------------------------------
+    // engine and rendering
+    //-------------------------------------------------------------
+    GameInitialize();
+    GetAssetHandles();
+
+    Run("GameEngine::loadAssets", 20, [&]
+    {
+        pGame->CleanupAll();
+        pGame->loadAssets();
+    });
+    if( mRegions.IsEmpty() ) pGame->loadAssets();  //the benchmark was filtered out
+
+    CreateLayers();
+    CreateTexts();
+
+    sf::FloatRect rcBounds(0,0,pGame->GetWidth(), pGame->GetHeight());
+    CSprite *s = new CSprite(tilesTexture,rcBounds, BA_STOP);
+    board.SetTexture(pGame->getRegion(tilesTexture));
+    board.SetPosition(28,31);
+    ReadHiScores(vhiscores);
+
+    sf::RenderTexture target;
+    target.create(pGame->GetWidth(), pGame->GetHeight());
+
+    {
+        int sc = 0;
+        Run("GameEngine::Text", 100000, [&]
+        {
+            pGame->Text("SCORE:  \n" + std::to_string(sc++), 240, 20, sf::Color::Black, 20, font, target);
+        });
+    }
+
+    {
+        int sc = 0;
+        Run("GameEngine::SetText + DrawText (new string)", 100000, [&]
+        {
+            pGame->SetText(scoreText, "SCORE:  \n" + std::to_string(sc++));
+            pGame->DrawText(scoreText, target);
+        });
+        Run("GameEngine::DrawText (same string)", 1000000, [&]
+        {
+            pGame->DrawText(scoreText, target);
+        });
+    }
+
+    Run("GameEngine::SnapshotKeys", 1000000, [&]
+    {
+        pGame->SetKey(sf::Keyboard::Left, true, sf::Time::Zero);
+        pGame->SnapshotKeys();
+        Keep(pGame->KeyPressed(sf::Keyboard::Left));
+        pGame->SetKey(sf::Keyboard::Left, false, sf::Time::Zero);
+    });
+
+    Run("GameEngine::showTexture", 100000, [&]
+    {
+        pGame->showTexture(frameTexture, 0, 0, target);
+    });
+
+    {
+        int x = 0;
+        Run("CSprite::SetPosition + OffsetPosition", 10000000, [&]
+        {
+            s->SetPosition(x % boardwidth * 18, x / boardwidth % boardheight * 18);
+            s->OffsetPosition(28, 31);
+            x++;
+        });
+    }
+
+    {
+        //the same bouncing sprites as objects and in the pool
+        for(int i=0;i<10000;i++)
+            pGame->AddSprite(new CSprite(tilesTexture, sf::Vector2f(i % 300, i % 460), sf::Vector2f(i % 7 - 3, i % 5 - 2),
+                i % 3, rcBounds, BA_BOUNCE));
+        Run("CSprite 10000 sprites Update + Draw", 200, [&]
+        {
+            pGame->UpdateSprites(sf::milliseconds(16));
+            pGame->DrawSprites(target);
+        });
+        pGame->CleanupSprites();
+
+        pGame->spritePool.Reserve(10000);
+        for(int i=0;i<10000;i++)
+            pGame->spritePool.Create(tilesTexture, sf::Vector2f(i % 300, i % 460), sf::Vector2f(i % 7 - 3, i % 5 - 2),
+                i % 3, rcBounds, BA_BOUNCE);
+        Run("SpritePool 10000 sprites Update + Draw", 200, [&]
+        {
+            pGame->spritePool.Update(sf::milliseconds(16));
+            pGame->spritePool.Draw(target);
+        });
+        pGame->spritePool.Clear();
+    }
+
+    for(int f=0;f<3;f++)
+    {
+        const GameState &g = fixtures[f];
+        Run(std::string("BoardRenderer::Update board + piece (") + names[f] + ")", 100000, [&]
+        {
+            board.Invalidate();
+            board.Update(g, 9);
+        });
+        Run(std::string("BoardRenderer::Update piece (") + names[f] + ")", 1000000, [&]
+        {
+            board.Update(g, 9);
+        });
+    }
+
+    {
+        StarryBackground stars(pGame->GetWidth(), pGame->GetHeight(), 5000);
+        Run("StarryBackground 5000 stars Update + Draw", 2000, [&]
+        {
+            stars.Update();
+            stars.Draw(target);
+        });
+
+        ScrollingBackground scroll(backgroundTexture, pGame->GetWidth(), pGame->GetHeight(), 1);
+        scroll.AddLayer(sf::IntRect(0,0,pGame->GetWidth(),160), 0, 0.5f);
+        scroll.AddLayer(sf::IntRect(0,320,pGame->GetWidth(),160), 320, 2);
+        Run("ScrollingBackground 3 layers Update + Draw", 100000, [&]
+        {
+            scroll.Update();
+            scroll.Draw(target);
+        });
+    }
+
+    state = GAME;
+    game = fixtures[1];
+    Run("TakeSnapshot + Publish + Read", 1000000, [&]
+    {
+        TakeSnapshot(snapshots.Back());
+        snapshots.Publish();
+        Keep(snapshots.Read().game.score);
+    });
+
+    state = MENU;
+    Run("GamePaint (menu)", 2000, [&]
+    {
+        GamePaint(target, 0);
+        target.display();
+    });
+
+    state = GAME;
+    for(int f=0;f<3;f++)
+    {
+        game = fixtures[f];
+        board.Invalidate();
+        Run(std::string("GamePaint (") + names[f] + ")", 2000, [&]
+        {
+            GamePaint(target, 0.5f);
+            target.display();
+        });
+    }
+
+    pGame->CleanupAll();
+    delete pGame;
+    delete s;
+
+    return EXIT_SUCCESS;
+}
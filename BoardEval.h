@@ -0,0 +1,189 @@
+//heuristic features of a board for the bot. every row is a bitmask, so the
+//features are computed with one 16 bit lane per bit of the row: all the
+//columns of a row are handled at once with AVX2 (16 lanes) or SSE2 (2 x 8 lanes).
+//without them it falls back to the scalar version. SSE2 is always there on
+//x86-64, AVX2 only when it's built for it (-mavx2, the Release AVX2 target).
+#ifndef BOARDEVAL_H
+#define BOARDEVAL_H
+
+#include <cstdlib>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "GameState.h"
+
+struct BoardFeatures{
+    int height;     //sum of the heights of the columns
+    int holes;      //empty cells with a used cell above
+    int bumpiness;  //sum of the height differences of neighbour columns
+    int lines;      //complete lines
+};
+
+//rows starts at the first spare row above the board, like GameState::rows
+void GetBoardFeaturesScalar(const rowmask *rows, BoardFeatures &f)
+{
+    int heights[boardwidth];
+    f.height = f.holes = f.bumpiness = f.lines = 0;
+
+    for(int j=0;j<boardwidth;j++)
+    {
+        rowmask bit = 1 << (j + wallbits);
+        heights[j] = 0;
+        for(int i=0;i<boardheight;i++)
+        {
+            bool used = rows[boardtop + i] & bit;
+            if( used && heights[j] == 0 ) heights[j] = boardheight - i;
+            else if( !used && heights[j] > 0 ) f.holes++;
+        }
+        f.height += heights[j];
+        if( j > 0 ) f.bumpiness += std::abs(heights[j] - heights[j-1]);
+    }
+
+    for(int i=0;i<boardheight;i++)
+        if( rows[boardtop + i] == fullrow ) f.lines++;
+}
+
+#if defined(__AVX2__)
+
+inline int HorizontalSum(__m256i v)
+{
+    //16 x 16 bits -> 8 x 32 bits -> 1
+    __m256i s = _mm256_madd_epi16(v, _mm256_set1_epi16(1));
+    __m128i t = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(1,0,3,2)));
+    t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtsi128_si32(t);
+}
+
+void GetBoardFeatures(const rowmask *rows, BoardFeatures &f)
+{
+    //lane j tests bit j of the row
+    const __m256i bits = _mm256_setr_epi16(0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+                                           0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, (short)0x8000);
+    __m256i seen = _mm256_setzero_si256();
+    __m256i heights = _mm256_setzero_si256();
+    __m256i holes = _mm256_setzero_si256();
+
+    for(int i=0;i<boardheight;i++)
+    {
+        __m256i row = _mm256_set1_epi16((short)rows[boardtop + i]);
+        __m256i used = _mm256_cmpeq_epi16(_mm256_and_si256(row, bits), bits);
+        seen = _mm256_or_si256(seen, used);
+        //the masks are -1 so subtracting them counts
+        heights = _mm256_sub_epi16(heights, seen);
+        holes = _mm256_sub_epi16(holes, _mm256_andnot_si256(used, seen));
+    }
+
+    //only the lanes of the columns, not the walls
+    const __m256i columns = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16((short)~emptyrow), bits), bits);
+    heights = _mm256_and_si256(heights, columns);
+    holes = _mm256_and_si256(holes, columns);
+
+    //heights of the next column in every lane, and only pairs of columns count
+    __m256i next = _mm256_alignr_epi8(_mm256_permute2x128_si256(heights, heights, 0x81), heights, 2);
+    __m256i pairs = _mm256_alignr_epi8(_mm256_permute2x128_si256(columns, columns, 0x81), columns, 2);
+    pairs = _mm256_and_si256(pairs, columns);
+    __m256i bumps = _mm256_and_si256(_mm256_abs_epi16(_mm256_sub_epi16(heights, next)), pairs);
+
+    f.height = HorizontalSum(heights);
+    f.holes = HorizontalSum(holes);
+    f.bumpiness = HorizontalSum(bumps);
+
+    //full rows, 16 rows at once and the rest
+    const __m256i full = _mm256_set1_epi16((short)fullrow);
+    __m256i r = _mm256_loadu_si256((const __m256i*)&rows[boardtop]);
+    f.lines = __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi16(r, full))) / 2;
+    for(int i=16;i<boardheight;i++)
+        if( rows[boardtop + i] == fullrow ) f.lines++;
+}
+
+#elif defined(__SSE2__)
+
+inline int HorizontalSum(__m128i v)
+{
+    //8 x 16 bits -> 4 x 32 bits -> 1
+    __m128i t = _mm_madd_epi16(v, _mm_set1_epi16(1));
+    t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(1,0,3,2)));
+    t = _mm_add_epi32(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtsi128_si32(t);
+}
+
+void GetBoardFeatures(const rowmask *rows, BoardFeatures &f)
+{
+    //lane j of lo tests bit j of the row, lane j of hi tests bit j + 8
+    const __m128i bitslo = _mm_setr_epi16(0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080);
+    const __m128i bitshi = _mm_setr_epi16(0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, (short)0x8000);
+    __m128i seenlo = _mm_setzero_si128(), seenhi = _mm_setzero_si128();
+    __m128i heightslo = _mm_setzero_si128(), heightshi = _mm_setzero_si128();
+    __m128i holeslo = _mm_setzero_si128(), holeshi = _mm_setzero_si128();
+
+    for(int i=0;i<boardheight;i++)
+    {
+        __m128i row = _mm_set1_epi16((short)rows[boardtop + i]);
+        __m128i usedlo = _mm_cmpeq_epi16(_mm_and_si128(row, bitslo), bitslo);
+        __m128i usedhi = _mm_cmpeq_epi16(_mm_and_si128(row, bitshi), bitshi);
+        seenlo = _mm_or_si128(seenlo, usedlo);
+        seenhi = _mm_or_si128(seenhi, usedhi);
+        //the masks are -1 so subtracting them counts
+        heightslo = _mm_sub_epi16(heightslo, seenlo);
+        heightshi = _mm_sub_epi16(heightshi, seenhi);
+        holeslo = _mm_sub_epi16(holeslo, _mm_andnot_si128(usedlo, seenlo));
+        holeshi = _mm_sub_epi16(holeshi, _mm_andnot_si128(usedhi, seenhi));
+    }
+
+    //only the lanes of the columns, not the walls
+    const __m128i walls = _mm_set1_epi16((short)~emptyrow);
+    const __m128i columnslo = _mm_cmpeq_epi16(_mm_and_si128(walls, bitslo), bitslo);
+    const __m128i columnshi = _mm_cmpeq_epi16(_mm_and_si128(walls, bitshi), bitshi);
+    heightslo = _mm_and_si128(heightslo, columnslo);
+    heightshi = _mm_and_si128(heightshi, columnshi);
+    holeslo = _mm_and_si128(holeslo, columnslo);
+    holeshi = _mm_and_si128(holeshi, columnshi);
+
+    //heights of the next column in every lane, and only pairs of columns count
+    __m128i nextlo = _mm_or_si128(_mm_srli_si128(heightslo, 2), _mm_slli_si128(heightshi, 14));
+    __m128i nexthi = _mm_srli_si128(heightshi, 2);
+    __m128i pairslo = _mm_and_si128(columnslo, _mm_or_si128(_mm_srli_si128(columnslo, 2), _mm_slli_si128(columnshi, 14)));
+    __m128i pairshi = _mm_and_si128(columnshi, _mm_srli_si128(columnshi, 2));
+    __m128i difflo = _mm_sub_epi16(heightslo, nextlo);
+    __m128i diffhi = _mm_sub_epi16(heightshi, nexthi);
+    //there is no abs in SSE2, max(d, -d) does the same
+    __m128i zero = _mm_setzero_si128();
+    __m128i bumpslo = _mm_and_si128(_mm_max_epi16(difflo, _mm_sub_epi16(zero, difflo)), pairslo);
+    __m128i bumpshi = _mm_and_si128(_mm_max_epi16(diffhi, _mm_sub_epi16(zero, diffhi)), pairshi);
+
+    f.height = HorizontalSum(_mm_add_epi16(heightslo, heightshi));
+    f.holes = HorizontalSum(_mm_add_epi16(holeslo, holeshi));
+    f.bumpiness = HorizontalSum(_mm_add_epi16(bumpslo, bumpshi));
+
+    //full rows, 8 rows at once and the rest
+    const __m128i full = _mm_set1_epi16((short)fullrow);
+    f.lines = 0;
+    int i = 0;
+    for(;i+8<=boardheight;i+=8)
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)&rows[boardtop + i]);
+        f.lines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(r, full))) / 2;
+    }
+    for(;i<boardheight;i++)
+        if( rows[boardtop + i] == fullrow ) f.lines++;
+}
+
+#else
+
+void GetBoardFeatures(const rowmask *rows, BoardFeatures &f)
+{
+    GetBoardFeaturesScalar(rows, f);
+}
+
+#endif
+
+float EvaluateBoard(const BoardFeatures &f)
+{
+    return -0.510066f * f.height + 0.760666f * f.lines
+           -0.35663f * f.holes - 0.184483f * f.bumpiness;
+}
+
+#endif
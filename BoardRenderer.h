@@ -0,0 +1,101 @@
+//draws the board and the actual piece with one draw call. every cell is a
+//textured quad of the tiles texture in one vertex array. the quads of the
+//board are only rebuilt when the board changes, the 4 quads of the piece
+//go at the end and are updated every frame.
+#ifndef BOARDRENDERER_H
+#define BOARDRENDERER_H
+
+#include <SFML/Graphics.hpp>
+
+#include "Atlas.h"
+#include "GameState.h"
+
+class BoardRenderer
+{
+public:
+    BoardRenderer();
+
+    //general methods
+    void Update(const GameState &g, float fall);  //fall is how far the piece is drawn down, in pixels
+    void Draw(sf::RenderTarget &target);
+    void Invalidate() { valid = false; };  //rebuilds the board in the next Update
+
+    //accessor methods
+    void SetTexture(const TextureRegion &region) { texture = region.texture; origin = sf::Vector2f(region.rect.left, region.rect.top); valid = false; };
+    void SetPosition(float x, float y) { offset = sf::Vector2f(x, y); valid = false; };
+    void SetTileSize(int isize) { tileSize = isize; valid = false; };
+
+protected:
+    sf::VertexArray vertices;
+    const sf::Texture *texture;
+    sf::Vector2f origin;  //of the tiles in the texture
+    sf::Vector2f offset;
+    int tileSize;
+    int boardVertices;  //vertices of the board, the piece goes after them
+    unsigned int boardVersion;
+    bool valid;
+
+    void SetQuad(sf::Vertex *quad, float x, float y, int tile);
+};
+
+BoardRenderer::BoardRenderer()
+{
+    vertices.setPrimitiveType(sf::Quads);
+    texture = nullptr;
+    tileSize = 18;
+    boardVertices = 0;
+    boardVersion = 0;
+    valid = false;
+}
+
+inline void BoardRenderer::SetQuad(sf::Vertex *quad, float x, float y, int tile)
+{
+    float tx = origin.x + tile * tileSize;
+    float ty = origin.y;
+    quad[0].position = sf::Vector2f(x, y);
+    quad[1].position = sf::Vector2f(x + tileSize, y);
+    quad[2].position = sf::Vector2f(x + tileSize, y + tileSize);
+    quad[3].position = sf::Vector2f(x, y + tileSize);
+    quad[0].texCoords = sf::Vector2f(tx, ty);
+    quad[1].texCoords = sf::Vector2f(tx + tileSize, ty);
+    quad[2].texCoords = sf::Vector2f(tx + tileSize, ty + tileSize);
+    quad[3].texCoords = sf::Vector2f(tx, ty + tileSize);
+}
+
+void BoardRenderer::Update(const GameState &g, float fall)
+{
+    //the board
+    if( !valid || g.boardVersion != boardVersion )
+    {
+        vertices.clear();
+        for(int i=0;i<boardheight;i++)
+            for(int j=0;j<boardwidth;j++)
+        {
+            if( g.colors[i][j] == 0 ) continue;
+            sf::Vertex quad[4];
+            SetQuad(quad, offset.x + j * tileSize, offset.y + i * tileSize, g.colors[i][j]);
+            for(int k=0;k<4;k++) vertices.append(quad[k]);
+        }
+        boardVertices = vertices.getVertexCount();
+        vertices.resize(boardVertices + 16);
+
+        boardVersion = g.boardVersion;
+        valid = true;
+    }
+
+    //the actual piece
+    const PieceShape &sh = shapes[g.piece.n][g.piece.r];
+    for(int i=0;i<4;i++)
+    {
+        float x = offset.x + (g.piece.x + sh.cells[i].x) * tileSize;
+        float y = offset.y + (g.piece.y + sh.cells[i].y) * tileSize + fall;
+        SetQuad(&vertices[boardVertices + i * 4], x, y, g.colorNum);
+    }
+}
+
+void BoardRenderer::Draw(sf::RenderTarget &target)
+{
+    target.draw(vertices, sf::RenderStates(texture));
+}
+
+#endif
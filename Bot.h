@@ -0,0 +1,88 @@
+//a bot that plays a GameState. when a new piece appears it tries every rotation
+//and column, drops the piece there and scores the board it leaves. then it
+//gives the inputs that take the piece to the best place.
+#ifndef BOT_H
+#define BOT_H
+
+#include "GameState.h"
+#include "BoardEval.h"
+
+class Bot
+{
+public:
+    Piece target;
+    int lastPieces;
+
+    Bot() { Reset(); };
+
+    //general methods
+    void Reset() { lastPieces = -1; };
+    void Plan(const GameState &g);
+    unsigned int GetInput(const GameState &g);
+};
+
+void Bot::Plan(const GameState &g)
+{
+    float best = -1e30f;
+    target = g.piece;
+
+    for(int r=0;r<4;r++)
+    {
+        //only the columns where the whole piece is inside the board
+        const PieceShape &sh = shapes[g.piece.n][r];
+        for(int x=-sh.left;x+sh.left+sh.width<=boardwidth;x++)
+        {
+            Piece p = g.piece;
+            p.r = r;
+            p.x = x;
+            if( !PieceFits(g.rows, p) ) continue;
+
+            //drop it
+            while( true )
+            {
+                p.y++;
+                if( !PieceFits(g.rows, p) ) break;
+            }
+            p.y--;
+
+            rowmask rows[boardtop + boardheight + boardbottom];
+            std::copy(g.rows, g.rows + boardtop + boardheight + boardbottom, rows);
+            PlacePiece(rows, p);
+
+            BoardFeatures f;
+            GetBoardFeatures(rows, f);
+            float score = EvaluateBoard(f);
+            if( score > best )
+            {
+                best = score;
+                target = p;
+            }
+        }
+    }
+}
+
+unsigned int Bot::GetInput(const GameState &g)
+{
+    if( g.pieces != lastPieces )
+    {
+        lastPieces = g.pieces;
+        Plan(g);
+    }
+
+    //rotate and move at the same time and drop when it's in place
+    unsigned int input = IN_NONE;
+    if( g.piece.x < target.x ) input |= IN_RIGHT;
+    if( g.piece.x > target.x ) input |= IN_LEFT;
+    if( g.piece.r != target.r )
+    {
+        Piece p = g.piece;
+        p.r = (p.r + 1) % 4;
+        if( PieceFits(g.rows, p) ) input |= IN_ROTATE;
+        //if it can't rotate here move it away from the wall first
+        else if( input == IN_NONE ) input |= (p.x < boardwidth / 2) ? IN_RIGHT : IN_LEFT;
+    }
+    if( input == IN_NONE ) input = IN_DOWN;
+    return input;
+}
+
+#endif
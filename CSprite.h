@@ -24,23 +24,27 @@ protected:
   int frameDelay;
   int frameTrigger;
 
+  // the image in its texture, the frames are side by side in it
+  sf::IntRect region;
+
   // helper method
+  void         SetImage(TextureHandle texture);
   void         UpdateFrame();
   virtual void CalcCollisionRect();
 
 public:
   // Constructor(s)/Destructor
-  CSprite(const std::string &texture);
-  CSprite(const std::string &texture, sf::FloatRect &Bounds,
+  CSprite(TextureHandle texture);
+  CSprite(TextureHandle texture, sf::FloatRect &Bounds,
     BOUNDSACTION baBoundsAction = BA_STOP);
-  CSprite(const std::string &texture, sf::Vector2f pPosition, sf::Vector2f pVelocity, int iZOrder,
+  CSprite(TextureHandle texture, sf::Vector2f pPosition, sf::Vector2f pVelocity, int iZOrder,
     sf::FloatRect &Bounds, BOUNDSACTION baBoundsAction = BA_STOP);
   virtual ~CSprite();
 
   // General Methods
   virtual SPRITEACTION  Update(sf::Time delta);
   virtual CSprite*      AddSprite();
-  void          Draw(sf::RenderWindow &window);
+  void          Draw(sf::RenderTarget &target);
   bool          IsPointInside(float x, float y);
   bool          TestCollision(CSprite* pTestSprite);
   void          Kill() {  Dying = true; };
@@ -55,24 +59,34 @@ public:
   sf::Vector2f   GetVelocity() { return velocity; };
   void    SetVelocity(float x, float y);
   void    SetVelocity(sf::Vector2f pvelocity);
-  bool    GetZOrder()               { return ZOrder; };
+  int     GetZOrder()               { return ZOrder; };
   void    SetZOrder(int iZOrder)    { ZOrder = iZOrder; };
   void    SetBounds(sf::FloatRect prcBounds) { rcBounds = prcBounds; };
   void    SetBoundsAction(BOUNDSACTION ba) { BoundsAction = ba; };
   bool    IsHidden()                { return Hidden; };
   void    SetHidden(bool bHidden)   { Hidden = bHidden; };
-  int     GetWidth()                { return psprite.getTexture()->getSize().x / numFrames; };
-  int     GetHeight()               { return psprite.getTexture()->getSize().y; };
+  int     GetWidth()                { return region.width / numFrames; };
+  int     GetHeight()               { return region.height; };
   std::string GetName() { return name; };
   void SetName(std::string str) { name = str; };
   void setNumFrames(int inumFrames, bool boneCycle = false);
   void setFrameDelay(int iframeDelay) { frameDelay = iframeDelay; };
-  void SetTextureRect(sf::IntRect ir) { psprite.setTextureRect(ir); };
+  void SetTextureRect(sf::IntRect ir)  //relative to the image
+    { psprite.setTextureRect(sf::IntRect(region.left + ir.left, region.top + ir.top, ir.width, ir.height)); };
 };
 
 //-----------------------------------------------------------------
 // Sprite Inline Helper Methods
 //-----------------------------------------------------------------
+inline void CSprite::SetImage(TextureHandle texture)
+{
+    TextureRegion *r = FindRegion(texture);
+    if( r == nullptr ) return;
+    region = r->rect;
+    psprite.setTexture(*r->texture);
+    psprite.setTextureRect(region);
+}
+
 inline void CSprite::UpdateFrame()
 {
     if(( frameDelay >= 0 ) && (--frameTrigger <= 0) )
@@ -92,7 +106,7 @@ inline void CSprite::UpdateFrame()
 
         //update the rect
         sf::IntRect rect = psprite.getTextureRect();
-        rect.left = rect.width * curFrame;
+        rect.left = region.left + rect.width * curFrame;
         psprite.setTextureRect(rect);
     }
 }
@@ -140,7 +154,7 @@ inline void CSprite::setNumFrames(int inumFrames, bool boneCycle)
 
     //recalculate the position
     sf::IntRect rect = psprite.getTextureRect();
-    rect.width = rect.width / numFrames;
+    rect.width = region.width / numFrames;
     psprite.setTextureRect(rect);
 }
 
@@ -182,10 +196,10 @@ inline void CSprite::SetVelocity(sf::Vector2f pvelocity)
 
 //////////////////////////////////////////////////////////////
 
-CSprite::CSprite(const std::string &texture)
+CSprite::CSprite(TextureHandle texture)
 {
   // Initialize the member variables
-  psprite.setTexture(mTextures[texture]);
+  SetImage(texture);
   psprite.setPosition(0,0);
 
   CalcCollisionRect();
@@ -202,10 +216,10 @@ CSprite::CSprite(const std::string &texture)
   oneCycle = false;
 }
 
-CSprite::CSprite(const std::string &texture, sf::FloatRect &prcBounds, BOUNDSACTION baBoundsAction)
+CSprite::CSprite(TextureHandle texture, sf::FloatRect &prcBounds, BOUNDSACTION baBoundsAction)
 {
   // Initialize the member variables
-  psprite.setTexture(mTextures[texture]);
+  SetImage(texture);
   psprite.setPosition(0,0);
 
   CalcCollisionRect();
@@ -222,11 +236,11 @@ CSprite::CSprite(const std::string &texture, sf::FloatRect &prcBounds, BOUNDSACT
   oneCycle = false;
 }
 
-CSprite::CSprite(const std::string &texture, sf::Vector2f ptPosition, sf::Vector2f ptVelocity, int iZOrder,
+CSprite::CSprite(TextureHandle texture, sf::Vector2f ptPosition, sf::Vector2f ptVelocity, int iZOrder,
     sf::FloatRect &prcBounds, BOUNDSACTION baBoundsAction)
 {
   // Initialize the member variables
-  psprite.setTexture(mTextures[texture]);
+  SetImage(texture);
   psprite.setPosition(ptPosition.x, ptPosition.y);
 
   CalcCollisionRect();
@@ -349,11 +363,11 @@ CSprite* CSprite::AddSprite()
     return nullptr;
 }
 
-void CSprite::Draw(sf::RenderWindow &window)
+void CSprite::Draw(sf::RenderTarget &target)
 {
   // Draw the sprite if it isn't hidden
   if (!Hidden)
-    window.draw(psprite);
+    target.draw(psprite);
 }
 
 
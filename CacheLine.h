@@ -0,0 +1,18 @@
+//data written by different threads is kept a cache line apart, so a write
+//of one thread doesn't take the line away from the others. it's done with
+//padding because alignas would need C++17 to go in the heap: before it, new
+//only aligns to 16 bytes and the aligned stores made for an alignas type
+//fault there (with AVX2, on the memory of a std::vector).
+#ifndef CACHELINE_H
+#define CACHELINE_H
+
+const int cachelinesize = 64;
+
+//a value alone on its cache lines, whatever is before or after it in memory
+template<class T> struct CacheLinePadded{
+    char before[cachelinesize];
+    T value;
+    char after[cachelinesize];
+};
+
+#endif
@@ -0,0 +1,127 @@
+//frame pacing. it decides when a frame is shown and measures how regular
+//the frames are:
+//  PACE_VSYNC     the driver waits for the screen refresh in display()
+//  PACE_LIMIT     sleeps most of the time to the next frame and spins the rest,
+//                 sleep alone wakes up too late and spinning alone burns a core
+//  PACE_UNCAPPED  no waiting at all, to measure how fast it can go
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include <SFML/System.hpp>
+#include <SFML/Window.hpp>
+
+#include "SampleStats.h"
+
+enum PACEMODE {PACE_VSYNC, PACE_LIMIT, PACE_UNCAPPED};
+
+class FramePacer
+{
+public:
+    FramePacer();
+
+    //general methods
+    void Apply(sf::Window &window);  //sets vsync on the window for the mode
+    void Wait();       //call it just before display
+    void FrameDone();  //call it just after display
+    void Skip() { lastFrame = sf::Time::Zero; };  //no frame this time, the next one is not measured
+    void Report(std::ostream &out);
+    void ResetStats() { frames.Reset(); Skip(); };
+
+    //accessor methods
+    int GetMode() { return mode; };
+    void SetMode(int imode) { mode = imode; };
+    float GetFrameRate() { return 1.f / period.asSeconds(); };
+    void SetFrameRate(float FrameRate) { period = sf::seconds(1.f / FrameRate); };
+    sf::Time GetSpinMargin() { return spinMargin; };
+
+protected:
+    int mode;
+    sf::Time period;      //time per frame in PACE_LIMIT
+    sf::Time spinMargin;  //the last part of the wait that is spun instead of slept
+    sf::Time nextFrame;   //when the next frame is due
+    sf::Time lastFrame;   //when the last one was shown, zero if it wasn't measured
+    sf::Clock clock;
+
+    SampleStats frames;  //time between frames
+};
+
+FramePacer::FramePacer()
+{
+    mode = PACE_LIMIT;
+    period = sf::seconds(1.f / 60.f);
+    spinMargin = sf::milliseconds(2);
+    nextFrame = sf::Time::Zero;
+    lastFrame = sf::Time::Zero;
+}
+
+void FramePacer::Apply(sf::Window &window)
+{
+    window.setFramerateLimit(0);  //SFML's limiter only sleeps, this one is better
+    window.setVerticalSyncEnabled(mode == PACE_VSYNC);
+    nextFrame = clock.getElapsedTime();
+    ResetStats();
+}
+
+void FramePacer::Wait()
+{
+    if( mode != PACE_LIMIT ) return;
+
+    sf::Time now = clock.getElapsedTime();
+    nextFrame += period;
+
+    //too late, start counting from now instead of hurrying the next frames
+    if( nextFrame < now )
+    {
+        nextFrame = now;
+        return;
+    }
+
+    //sleep most of the time, the oversleep says how much has to be spun
+    sf::Time sleepEnd = nextFrame - spinMargin;
+    if( sleepEnd > now )
+    {
+        sf::sleep(sleepEnd - now);
+        sf::Time over = clock.getElapsedTime() - sleepEnd;
+        if( over < sf::Time::Zero ) over = sf::Time::Zero;
+
+        //the margin follows twice the oversleep, between 0.5 and 4 ms
+        sf::Time target = std::min(std::max(over + over, sf::microseconds(500)), sf::milliseconds(4));
+        spinMargin = sf::microseconds((spinMargin.asMicroseconds() * 7 + target.asMicroseconds()) / 8);
+    }
+
+    while( clock.getElapsedTime() < nextFrame ) {}
+}
+
+void FramePacer::FrameDone()
+{
+    sf::Time now = clock.getElapsedTime();
+    if( lastFrame > sf::Time::Zero )
+    {
+        frames.Add((now - lastFrame).asSeconds() * 1000.f);
+    }
+    lastFrame = now;
+}
+
+void FramePacer::Report(std::ostream &out)
+{
+    std::vector<float> times = frames.Sorted();
+    int n = times.size();
+    if( n == 0 ) return;
+    float median = times[n / 2];
+
+    //jitter is how far every frame is from the usual one
+    std::vector<float> jitter(n);
+    for(int i=0;i<n;i++) jitter[i] = times[i] > median ? times[i] - median : median - times[i];
+    std::sort(jitter.begin(), jitter.end());
+
+    const char *modes[3] = { "vsync", "limit", "uncapped" };
+    out << "frames      " << n << " (" << modes[mode] << ")" << std::endl;
+    PrintPercentiles(out, "frame ms    ", times);
+    PrintPercentiles(out, "jitter ms   ", jitter);
+}
+
+#endif
@@ -4,14 +4,50 @@ void GameStart();
 void GameEnd();
 void GameActivate();
 void GameDeactivate();
-void GamePaint(sf::RenderWindow &window);
-void GameCycle(sf::Time delta);
+void GamePaint(sf::RenderTarget &target, float alpha);  //alpha is the fraction of cycle since the last one
+void GamePublish();  //after the cycles of every frame, the game gives its state to the render thread if there is one
+void GameCycle(sf::Time delta);  //delta is always the time per frame
 void HandleKeys();
 void MouseButtonDown(int x,int y, bool bLeft);
 void MouseButtonUp(int x, int y, bool bLeft);
 void MouseMove(int x, int y);
 bool SpriteCollision(CSprite* pSpriteHitter, CSprite* pSpriteHittee);
 void SpriteDying(CSprite* pSprite);
+void GameAssetsLoaded();  //the assets loading in the background are ready
+
+//a static picture painted once in a render texture and then drawn with a
+//single call, until it's invalidated because something in it changed
+struct Layer{
+    sf::RenderTexture texture;
+    sf::Sprite sprite;
+    void (*paint)(sf::RenderTarget &target);  //paints the layer
+    bool opaque;  //drawn without blending, it covers everything under it
+    bool dirty;
+};
+
+//an asset decoded by a worker thread, waiting for the main thread to give it
+//to the video or the sound card
+struct PendingAsset{
+    std::string datatype, name, filename;
+    const unsigned char *data;  //in the archive, or null to read the file
+    size_t size;
+    bool atlas;  //the image goes in the atlas
+    AtlasImage image;
+    std::vector<sf::Int16> samples;
+    unsigned int channels, sampleRate;
+    bool ok;
+    bool uploaded;
+    std::atomic<bool> ready;  //the worker is done with it
+};
+
+//a text kept between frames, the glyphs are only laid out again when the
+//string, the size or the color change
+struct TextItem{
+    sf::Text text;
+    std::string str;
+    int size;
+    sf::Color color;
+};
 
 //game engine class
 class GameEngine
@@ -25,9 +61,25 @@ public:
     bool running;
 
     //keyboard handling
-    // the keyboard's state in the current and the previous frame
+    // the keys down now, kept from the KeyPressed and KeyReleased events
+    bool KeyDown[sf::Keyboard::KeyCount];
+    // pressed and released since the last frame, a tap shorter than a frame isn't lost
+    bool KeyDownEvent[sf::Keyboard::KeyCount];
+    bool KeyUpEvent[sf::Keyboard::KeyCount];
+    // the snapshot the game reads during the frame
     bool CurrentKeyState[sf::Keyboard::KeyCount];
     bool PreviousKeyState[sf::Keyboard::KeyCount];
+    bool PressedKeyState[sf::Keyboard::KeyCount];
+    bool ReleasedKeyState[sf::Keyboard::KeyCount];
+    bool pollKeys;  //asks the system for every key each frame instead, for when the events can't be trusted
+    // the presses and releases in order, the ones since the last snapshot and the ones of this frame
+    std::vector<KeyStroke> vKeyStrokes;
+    std::vector<KeyStroke> vFrameKeyStrokes;
+    // the keys read by the input thread, their events are left out
+    InputThread inputThread;
+    bool threadKeys[sf::Keyboard::KeyCount];
+    bool threadedInputWanted;  //the game uses the keys of the thread now
+    bool threadedInput;  //the game starts the input thread if it's asked for
 
     //mouse
     bool mouseClicked = false;
@@ -39,9 +91,42 @@ public:
     sf::Clock clock;
     sf::Time timePerFrame;
     sf::Time elapsed = sf::Time::Zero;
+    int maxCatchUp;  //most cycles run in one frame to catch up
+    sf::Clock runClock;  //since the engine started, the time of the keys and the ticks
+    sf::Time tickTime;   //the time the cycle running now ends at
+
+    //render on demand: a frame is only drawn when something changed or the
+    //game is animating, the rest of the time the loop waits for events
+    bool redraw;
+    bool animating;
+    sf::Time idleWait;  //most time waiting for an event before running the game again
+
+    //when the frames are shown
+    FramePacer pacer;
+
+    //drawing in its own thread, GamePaint is called from it with what GamePublish left
+    std::thread renderThread;
+    std::atomic<bool> rendering;
+    bool threadedRender;  //the render thread starts when the assets are loaded
+    std::atomic<bool> renderAnimating;  //it draws at the pacer's rate
+    std::atomic<bool> renderRequested;  //it draws one frame
 
     //Sprites
     std::vector<CSprite*> vSprites;
+    bool spritesSorted;  //by z-order, they are sorted when they are drawn
+    SpritePool spritePool;  //the small ones in big numbers, drawn over the others
+
+    //static layers
+    std::vector<Layer*> vLayers;
+
+    //retained texts
+    std::vector<TextItem> vTexts;
+
+    //assets loading in the background
+    AssetArchive archive;  //mapped while the assets made from it are used
+    ThreadPool *loaderPool;
+    bool loadingFinished;  //the loading ended and the game wasn't told yet
+    std::vector<PendingAsset*> vPending;
 
     //Helper methods
     bool CheckSpriteCollision(CSprite* pTestSprite);
@@ -53,34 +138,73 @@ public:
     static GameEngine* GetEngine() { return pGameEngine; };
     bool Initialize();  //initialize variables, create window, calls GameStart
 
-    void HandleEvents(sf::RenderWindow &window);
+    void HandleEvents(sf::RenderWindow &window, sf::Time wait = sf::Time::Zero);  //waits for the first event up to wait
+    void StartRenderThread();
+    void StopRenderThread();
+    void RenderLoop();
+    void RequestFrames();  //tells the render thread what the loop would draw without it
+    bool WaitEvent(sf::Window &window, sf::Event &event, sf::Time timeout);
+    void SetKey(sf::Keyboard::Key Key, bool down, sf::Time time);
+    void StartInputThread(const std::vector<sf::Keyboard::Key> &keys);
+    void StopInputThread();
+    void ReleaseKeys();  //all of them, the releases aren't seen without the focus
+    void SnapshotKeys();
     void AddSprite(CSprite* pSprite);
-    void DrawSprites(sf::RenderWindow &window);
+    void SortSprites();
+    void DrawSprites(sf::RenderTarget &target);
     void UpdateSprites(sf::Time delta);
     void CleanupSprites();
     CSprite* IsPointInSprite(float x, float y);
 
     bool loadTexture(const std::string &name, const std::string &filename);
-    sf::Texture &getTexture(const std::string &name) { return mTextures[name]; };
-    void showTexture(const std::string &name, float x, float y, sf::RenderWindow &window);
+    void BuildAtlas(const std::vector<const AtlasImage*> &images);
+    TextureHandle GetTextureHandle(const std::string &name) { return mRegions.Intern(name); };  //valid before it's loaded
+    TextureRegion getRegion(TextureHandle texture);
+    const sf::Texture &getTexture(TextureHandle texture) { return *getRegion(texture).texture; };  //the atlas page if it was packed
+    void showTexture(TextureHandle texture, float x, float y, sf::RenderTarget &target);
     void CleanupTextures();
 
+    int CreateLayer(void (*paint)(sf::RenderTarget &target), bool opaque);  //returns the layer number
+    void InvalidateLayer(int layer) { vLayers[layer]->dirty = true; };
+    void InvalidateLayers();
+    void DrawLayer(int layer, sf::RenderTarget &target);
+    void CleanupLayers();
+
     bool loadSoundBuffer(const std::string &name, const std::string &filename);
-    void playSound(const std::string &name);
+    SoundHandle GetSoundHandle(const std::string &name) { return mSounds.Intern(name); };
+    void playSound(SoundHandle sound);
     void CleanupSounds();
 
     bool openMusic(const std::string &name, const std::string &filename);
-    void playMusic(const std::string &name, bool loop);
-    void pauseMusic(const std::string &name);
-    void continueMusic(const std::string &name);
-    void stopMusic(const std::string &name);
+    bool openMusic(const std::string &name, const void *data, size_t size);  //data must live as long as the music
+    MusicHandle GetMusicHandle(const std::string &name) { return mMusic.Intern(name); };
+    void playMusic(MusicHandle music, bool loop);
+    void pauseMusic(MusicHandle music);
+    void continueMusic(MusicHandle music);
+    void stopMusic(MusicHandle music);
     void CleanupMusic();
 
     bool loadFont(const std::string &name, const std::string &filename);
-    void Text(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, const std::string &fontname, sf::RenderWindow &window);
+    bool loadFont(const std::string &name, const void *data, size_t size);  //data must live as long as the font
+    FontHandle GetFontHandle(const std::string &name) { return mFonts.Intern(name); };
+    void Text(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, FontHandle font, sf::RenderTarget &target);
     void CleanupFonts();
 
-    void loadAssets();
+    int CreateText(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, FontHandle font);  //returns the text number
+    void SetText(int item, const std::string &pstr);
+    void SetTextStyle(int item, sf::Color pcolor, int psize);
+    void SetTextPosition(int item, float px, float py) { if( IsText(item) ) vTexts[item].text.setPosition(px, py); };
+    void DrawText(int item, sf::RenderTarget &target) { if( IsText(item) ) target.draw(vTexts[item].text); };
+    bool IsText(int item) { return item >= 0 && item < (int)vTexts.size(); };  //the others are ignored
+    void CleanupTexts();
+
+    void loadAssets();  //loads all the assets before returning
+    void StartLoadingAssets(const std::string &first = "");  //first is loaded before returning, the rest in the background
+    bool UploadAssets();  //takes the assets decoded since the last call, true when all of them are loaded
+    void CancelLoading();
+    bool IsLoading() { return loaderPool != nullptr; };
+    bool LoadingFinished();  //true once when the loading ends, with the assets or without them
+    void ReportMissingAssets();  //the handles asked for that have no asset
     void CleanupAll();
 
     //Accessor methods
@@ -89,15 +213,37 @@ public:
     std::string GetCaption() { return caption; };
     sf::Time GetTimePerFrame() { return timePerFrame; };
     void SetFrameRate(float FrameRate) { timePerFrame = sf::seconds(1.f / FrameRate); };
+    int GetMaxCatchUp() { return maxCatchUp; };
+    void SetMaxCatchUp(int imaxCatchUp) { maxCatchUp = imaxCatchUp; };
     bool GetSleep() { return sleep; };
     void SetSleep(bool bsleep) { sleep = bsleep; };
-
-    //keyboard functions
+    void Redraw() { redraw = true; };
+    bool NeedsRedraw() { return redraw || (animating && !sleep); };
+    void SetRedraw(bool bredraw) { redraw = bredraw; };
+    bool GetAnimating() { return animating; };
+    void SetAnimating(bool banimating) { animating = banimating; };
+    bool IsIdle() { return sleep || !animating; };
+    sf::Time GetIdleWait() { return idleWait; };
+    void SetIdleWait(sf::Time tidleWait) { idleWait = tidleWait; };
+    sf::Time GetTime() { return runClock.getElapsedTime(); };
+    sf::Time GetTickTime() { return tickTime; };
+    void SetTickTime(sf::Time ttickTime) { tickTime = ttickTime; };
+    const std::vector<KeyStroke> &GetKeyStrokes() { return vFrameKeyStrokes; };  //of this frame, in order
+    bool GetThreadedRender() { return threadedRender; };
+    void SetThreadedRender(bool bthreadedRender) { threadedRender = bthreadedRender; };
+    bool IsRendering() { return rendering.load(std::memory_order_relaxed); };  //in the render thread
+    bool GetThreadedInput() { return threadedInput; };
+    void SetThreadedInput(bool bthreadedInput) { threadedInput = bthreadedInput; };
+    void SetThreadedInputWanted(bool bwanted) { threadedInputWanted = bwanted; inputThread.SetActive(bwanted && !sleep); };  //it only reads the keys then
+    bool GetKeyPolling() { return pollKeys; };
+    void SetKeyPolling(bool bpollKeys) { pollKeys = bpollKeys; };
+
+    //keyboard functions, they read the snapshot of the frame
     bool KeyPressed(sf::Keyboard::Key Key)
-        { return (CurrentKeyState[Key] && !PreviousKeyState[Key]); }
+        { return PressedKeyState[Key]; }
 
     bool KeyReleased(sf::Keyboard::Key Key)
-        { return (!CurrentKeyState[Key] && PreviousKeyState[Key]); }
+        { return ReleasedKeyState[Key]; }
 
     bool KeyHeld(sf::Keyboard::Key Key)
         { return CurrentKeyState[Key]; }
@@ -115,7 +261,29 @@ GameEngine::GameEngine(const std::string &pcaption, int pwidth, int pheight)
     height = pheight;
     sleep = false;
     running = true;
+    maxCatchUp = 5;
+    redraw = true;
+    animating = false;
+    idleWait = sf::milliseconds(100);
+    loaderPool = nullptr;
+    loadingFinished = false;
+    pollKeys = false;
+    threadedInput = false;
+    threadedInputWanted = true;
+    threadedRender = false;
+    rendering = false;
+    renderAnimating = false;
+    renderRequested = false;
+    tickTime = sf::Time::Zero;
+    vKeyStrokes.reserve(64);
+    vFrameKeyStrokes.reserve(64);
+    for(int i=0;i<sf::Keyboard::KeyCount;i++)
+    {
+        KeyDown[i] = KeyDownEvent[i] = KeyUpEvent[i] = threadKeys[i] = false;
+        CurrentKeyState[i] = PreviousKeyState[i] = PressedKeyState[i] = ReleasedKeyState[i] = false;
+    }
     vSprites.reserve(50);
+    spritesSorted = true;
 }
 
 bool GameEngine::Initialize()
@@ -127,28 +295,48 @@ bool GameEngine::Initialize()
     int y = ( sf::VideoMode::getDesktopMode().height - height ) / 2;
     window.setPosition(sf::Vector2i( x, y));
 
+    //a key held down is one press, not a press every repeat
+    window.setKeyRepeatEnabled(false);
+
+    pacer.Apply(window);
+
     return true;
 }
 
-void GameEngine::HandleEvents(sf::RenderWindow &window)
+void GameEngine::HandleEvents(sf::RenderWindow &window, sf::Time wait)
 {
     sf::Event event;
 
-    while(window.pollEvent(event))
+    bool pending = (wait > sf::Time::Zero) ? WaitEvent(window, event, wait) : window.pollEvent(event);
+    for( ; pending; pending = window.pollEvent(event))
     {
+        //anything that happens to the window can change what's on it
+        redraw = true;
+
         //close window or press Escape key
         if((event.type == sf::Event::Closed) || ((event.type == sf::Event::KeyPressed)
                                                 && (event.key.code == sf::Keyboard::Escape)))
                                                     running = false;
 
+        //the keys of the input thread come from it, with a better time
+        if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased)
+        {
+            sf::Keyboard::Key code = event.key.code;
+            if( code < 0 || code >= sf::Keyboard::KeyCount || !threadKeys[code] )
+                SetKey(code, event.type == sf::Event::KeyPressed, GetTime());
+        }
+
         if (event.type == sf::Event::LostFocus)
         {
+            ReleaseKeys();
+            inputThread.SetActive(false);
             GameDeactivate();
             sleep = true;
         }
 
         if (event.type == sf::Event::GainedFocus)
         {
+            inputThread.SetActive(threadedInputWanted);
             GameActivate();
             sleep = false;
         }
@@ -196,15 +384,131 @@ void GameEngine::HandleEvents(sf::RenderWindow &window)
         }
     }
 
-    // Save the state of each keyboard key (must be done before any Key* function is executed)
-    for(unsigned int i = 0; i < sf::Keyboard::KeyCount; ++i)
+    // the state of the keys for this frame (must be done before any Key* function is executed)
+    SnapshotKeys();
+}
+
+void GameEngine::SetKey(sf::Keyboard::Key Key, bool down, sf::Time time)
+{
+    if( Key < 0 || Key >= sf::Keyboard::KeyCount ) return;  //a key SFML doesn't know
+    if( KeyDown[Key] == down ) return;  //a repeat
+    KeyDown[Key] = down;
+    if( down ) KeyDownEvent[Key] = true;
+    else KeyUpEvent[Key] = true;
+
+    vKeyStrokes.push_back(KeyStroke{Key, down, time});
+}
+
+void GameEngine::ReleaseKeys()
+{
+    for(int i=0;i<sf::Keyboard::KeyCount;i++) SetKey((sf::Keyboard::Key)i, false, GetTime());
+}
+
+//the thread reads these keys, their window events are left out
+void GameEngine::StartInputThread(const std::vector<sf::Keyboard::Key> &keys)
+{
+    StopInputThread();
+    for(size_t i=0;i<keys.size();i++) threadKeys[keys[i]] = true;
+    inputThread.SetActive(threadedInputWanted && !sleep);
+    inputThread.Start(keys, runClock);
+}
+
+void GameEngine::StopInputThread()
+{
+    inputThread.Stop();
+    for(int i=0;i<sf::Keyboard::KeyCount;i++) threadKeys[i] = false;
+}
+
+void GameEngine::SnapshotKeys()
+{
+    //the strokes of the input thread, with the time it saw them
+    KeyStroke stroke;
+    while( inputThread.Pop(stroke) ) SetKey(stroke.key, stroke.down, stroke.time);
+
+    //every key is a round trip to the window system, only when asked for
+    if( pollKeys && !sleep )
+    {
+        for(int i=0;i<sf::Keyboard::KeyCount;i++)
+            if( !threadKeys[i] ) SetKey((sf::Keyboard::Key)i, sf::Keyboard::isKeyPressed((sf::Keyboard::Key)i), GetTime());
+    }
+
+    for(int i=0;i<sf::Keyboard::KeyCount;i++)
     {
-        // Save the keyboard's state from the previous frame
         PreviousKeyState[i] = CurrentKeyState[i];
+        CurrentKeyState[i] = KeyDown[i];
+        PressedKeyState[i] = KeyDownEvent[i];
+        ReleasedKeyState[i] = KeyUpEvent[i];
+        KeyDownEvent[i] = KeyUpEvent[i] = false;
+
+        if( PressedKeyState[i] || ReleasedKeyState[i] ) redraw = true;
+    }
+
+    vFrameKeyStrokes.swap(vKeyStrokes);
+    vKeyStrokes.clear();
+}
+
+//the window's context goes to the render thread, the events stay in this one
+void GameEngine::StartRenderThread()
+{
+    if( renderThread.joinable() ) return;
+    window.setActive(false);
+    renderAnimating = false;
+    renderRequested = true;
+    rendering = true;
+    renderThread = std::thread(&GameEngine::RenderLoop, this);
+}
 
-        // And save the keyboard's state in the current frame
-        CurrentKeyState[i] = sf::Keyboard::isKeyPressed((sf::Keyboard::Key)i);
+void GameEngine::StopRenderThread()
+{
+    if( !renderThread.joinable() ) return;
+    rendering = false;
+    renderThread.join();
+    window.setActive(true);
+}
+
+//draws what the game published at the pacer's rate while it's animating,
+//and once when something changed, the game takes the fraction of cycle from
+//its own state
+void GameEngine::RenderLoop()
+{
+    window.setActive(true);
+    while( rendering.load(std::memory_order_relaxed) )
+    {
+        if( !renderAnimating.load(std::memory_order_acquire) && !renderRequested.exchange(false, std::memory_order_acq_rel) )
+        {
+            pacer.Skip();
+            sf::sleep(sf::milliseconds(5));
+            continue;
+        }
+        GamePaint(window, 0);
+        pacer.Wait();
+        window.display();
+        pacer.FrameDone();
+    }
+    window.setActive(false);
+}
+
+//after GamePublish, the snapshot is there before the render thread is told
+void GameEngine::RequestFrames()
+{
+    renderAnimating.store(animating && !sleep, std::memory_order_release);
+    if( !redraw ) return;
+    renderRequested.store(true, std::memory_order_release);
+    redraw = false;
+}
+
+//SFML 2.5 waitEvent can't time out, so it polls and sleeps a little between polls
+bool GameEngine::WaitEvent(sf::Window &window, sf::Event &event, sf::Time timeout)
+{
+    const sf::Time pollInterval = sf::milliseconds(10);
+    sf::Clock waited;
+    while( !window.pollEvent(event) )
+    {
+        sf::Time left = timeout - waited.getElapsedTime();
+        if( left <= sf::Time::Zero ) return false;
+        sf::sleep(std::min(left, pollInterval));
     }
+    return true;
 }
 
 //---------------------------------------------------------------------
@@ -212,53 +516,141 @@ void GameEngine::HandleEvents(sf::RenderWindow &window)
 //---------------------------------------------------------------------
 bool GameEngine::loadTexture(const std::string &name, const std::string &filename)
 {
-    sf::Texture t;
-    if( !t.loadFromFile(filename)) return false;
+    //loaded in its place in the table, not copied there
+    AssetHandle<sf::Texture> h = mTextures.Intern(name);
+    sf::Texture &t = mTextures.Create(h);
+    if( !t.loadFromFile(filename))
+    {
+        mTextures.Remove(h);
+        return false;
+    }
 
-    mTextures[name] = t;
+    //the whole texture is the image
+    sf::Vector2u size = t.getSize();
+    mRegions.Create(mRegions.Intern(name)) = TextureRegion{&t, sf::IntRect(0, 0, size.x, size.y)};
     return true;
 }
 
-void GameEngine::showTexture(const std::string &name, float x, float y, sf::RenderWindow &window)
+void GameEngine::BuildAtlas(const std::vector<const AtlasImage*> &images)
+{
+    std::vector<sf::IntRect> rects;
+    std::vector<int> pages;
+    std::vector<sf::Image> pageImages = PackAtlas(images, rects, pages);
+
+    //the pages are textures like the others, atlas0, atlas1...
+    std::vector<sf::Texture*> pageTextures;
+    for(size_t p=0;p<pageImages.size();p++)
+    {
+        sf::Texture &t = mTextures.Create(mTextures.Intern("atlas" + std::to_string(p)));
+        if( !t.loadFromImage(pageImages[p]) )
+            std::cout << "Error creating atlas page " << p << std::endl;
+        pageTextures.push_back(&t);
+    }
+
+    for(size_t i=0;i<images.size();i++)
+    {
+        if( pages[i] < 0 ) continue;
+        mRegions.Create(mRegions.Intern(images[i]->name)) = TextureRegion{pageTextures[pages[i]], rects[i]};
+    }
+}
+
+//an empty region if it isn't loaded, the missing ones are told when the loading ends
+TextureRegion GameEngine::getRegion(TextureHandle texture)
+{
+    TextureRegion *r = mRegions.Get(texture);
+    if( r != nullptr ) return *r;
+
+    static sf::Texture empty;
+    return TextureRegion{&empty, sf::IntRect()};
+}
+
+void GameEngine::showTexture(TextureHandle texture, float x, float y, sf::RenderTarget &target)
 {
-    sf::Sprite sp;
-    sp.setTexture(mTextures[name]);
+    TextureRegion *r = mRegions.Get(texture);
+    if( r == nullptr ) return;
+    sf::Sprite sp(*r->texture, r->rect);
     sp.setPosition(x,y);
-    window.draw(sp);
+    target.draw(sp);
 }
 
 void GameEngine::CleanupTextures()
 {
-    mTextures.clear();
+    mRegions.Clear();
+    mTextures.Clear();
 }
 
 //-----------------------------------------------------------------
-// Sounds
+// Layers
 //-----------------------------------------------------------------
-bool GameEngine::loadSoundBuffer(const std::string &name, const std::string &filename)
+int GameEngine::CreateLayer(void (*paint)(sf::RenderTarget &target), bool opaque)
 {
-    //soundbuffer
-    sf::SoundBuffer sb;
-    if( !sb.loadFromFile(filename) ) return false;
+    Layer *l = new Layer();
+    if( !l->texture.create(width, height) )
+    {
+        std::cout << "Error creating layer" << std::endl;
+    }
+    l->sprite.setTexture(l->texture.getTexture());
+    l->paint = paint;
+    l->opaque = opaque;
+    l->dirty = true;  //painted the first time it's drawn
+
+    vLayers.push_back(l);
+    return vLayers.size() - 1;
+}
+
+void GameEngine::InvalidateLayers()
+{
+    for(size_t i=0;i<vLayers.size();i++) vLayers[i]->dirty = true;
+}
+
+void GameEngine::DrawLayer(int layer, sf::RenderTarget &target)
+{
+    Layer *l = vLayers[layer];
+    if( l->dirty )
+    {
+        l->texture.clear(sf::Color::Transparent);
+        l->paint(l->texture);
+        l->texture.display();
+        l->dirty = false;
+    }
+
+    //an opaque layer replaces the pixels under it without reading them.
+    //the colors of the others were already multiplied by alpha when painted
+    if( l->opaque ) target.draw(l->sprite, sf::RenderStates(sf::BlendNone));
+    else target.draw(l->sprite, sf::RenderStates(sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha)));
+}
 
-    mSoundBuffers[name] = sb;
+void GameEngine::CleanupLayers()
+{
+    for(size_t i=0;i<vLayers.size();i++) delete vLayers[i];
+    vLayers.clear();
+}
 
-    //sound
-    sf::Sound s;
-    s.setBuffer(mSoundBuffers[name]);
-    mSounds[name] = s;
+//-----------------------------------------------------------------
+// Sounds
+//-----------------------------------------------------------------
+bool GameEngine::loadSoundBuffer(const std::string &name, const std::string &filename)
+{
+    SoundHandle h = mSounds.Intern(name);
+    SoundAsset &sa = mSounds.Create(h);
+    if( !sa.buffer.loadFromFile(filename) )
+    {
+        mSounds.Remove(h);
+        return false;
+    }
+    sa.sound.setBuffer(sa.buffer);
     return true;
 }
 
-void GameEngine::playSound(const std::string &name)
+void GameEngine::playSound(SoundHandle sound)
 {
-    mSounds[name].play();
+    SoundAsset *sa = mSounds.Get(sound);
+    if( sa != nullptr ) sa->sound.play();
 }
 
 void GameEngine::CleanupSounds()
 {
-    mSoundBuffers.clear();
-    mSounds.clear();
+    mSounds.Clear();
 }
 
 //------------------------------
@@ -266,103 +658,377 @@ void GameEngine::CleanupSounds()
 //------------------------------
 bool GameEngine::openMusic(const std::string &name, const std::string &filename)
 {
-    sf::Music* tempmusic = new sf::Music();
-    mMusic[name] = tempmusic;
-    if( !mMusic[name]->openFromFile(filename) ) return false;
+    MusicHandle h = mMusic.Intern(name);
+    if( !mMusic.Create(h).openFromFile(filename) )
+    {
+        mMusic.Remove(h);
+        return false;
+    }
+    return true;
+}
 
+bool GameEngine::openMusic(const std::string &name, const void *data, size_t size)
+{
+    MusicHandle h = mMusic.Intern(name);
+    if( !mMusic.Create(h).openFromMemory(data, size) )
+    {
+        mMusic.Remove(h);
+        return false;
+    }
     return true;
 }
 
-void GameEngine::playMusic(const std::string &name, bool loop)
+void GameEngine::playMusic(MusicHandle music, bool loop)
 {
-    mMusic[name]->setLoop(loop);
-    mMusic[name]->play();
+    sf::Music *m = mMusic.Get(music);
+    if( m == nullptr ) return;  //not loaded yet
+    m->setLoop(loop);
+    m->play();
 }
 
-void GameEngine::pauseMusic(const std::string &name)
+void GameEngine::pauseMusic(MusicHandle music)
 {
-    mMusic[name]->pause();
+    sf::Music *m = mMusic.Get(music);
+    if( m != nullptr ) m->pause();
 }
 
-void GameEngine::continueMusic(const std::string &name)
+void GameEngine::continueMusic(MusicHandle music)
 {
-    mMusic[name]->play();
+    sf::Music *m = mMusic.Get(music);
+    if( m != nullptr ) m->play();
 }
 
-void GameEngine::stopMusic(const std::string &name)
+void GameEngine::stopMusic(MusicHandle music)
 {
-    mMusic[name]->stop();
+    sf::Music *m = mMusic.Get(music);
+    if( m != nullptr ) m->stop();
 }
 
 void GameEngine::CleanupMusic()
 {
-    for( std::map<std::string, sf::Music*>::iterator it = mMusic.begin(); it != mMusic.end(); ++it )
-    {
-      delete (it->second);
-    }
-    mMusic.clear();
+    mMusic.Clear();
 }
 //-----------------------------
 //fonts
 //-----------------------------
 bool GameEngine::loadFont(const std::string &name, const std::string &filename)
 {
-    sf::Font f;
-    if( !f.loadFromFile(filename) ) return false;
-    mFonts[name] = f;
+    FontHandle h = mFonts.Intern(name);
+    if( !mFonts.Create(h).loadFromFile(filename) )
+    {
+        mFonts.Remove(h);
+        return false;
+    }
     return true;
 }
 
-void GameEngine::Text(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, const std::string &fontname, sf::RenderWindow &window)
+void GameEngine::Text(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, FontHandle font, sf::RenderTarget &target)
 {
+    sf::Font *f = mFonts.Get(font);
+    if( f == nullptr ) return;
+
     sf::Text str;
     str.setString(pstr);
-    str.setFont(mFonts[fontname]);
+    str.setFont(*f);
     str.setCharacterSize(psize);
     str.setPosition(px, py);
     str.setFillColor(pcolor);
-    window.draw(str);
+    target.draw(str);
+}
+
+bool GameEngine::loadFont(const std::string &name, const void *data, size_t size)
+{
+    FontHandle h = mFonts.Intern(name);
+    if( !mFonts.Create(h).loadFromMemory(data, size) )
+    {
+        mFonts.Remove(h);
+        return false;
+    }
+    return true;
 }
 
 void GameEngine::CleanupFonts()
 {
-    mFonts.clear();
+    mFonts.Clear();
+}
+
+int GameEngine::CreateText(const std::string &pstr, float px, float py, sf::Color pcolor, int psize, FontHandle font)
+{
+    //without the font it's an empty text, the missing font was told when the loading ended
+    sf::Font *f = mFonts.Get(font);
+
+    TextItem t;
+    if( f != nullptr ) t.text.setFont(*f);
+    t.text.setString(pstr);
+    t.text.setCharacterSize(psize);
+    t.text.setPosition(px, py);
+    t.text.setFillColor(pcolor);
+    t.str = pstr;
+    t.size = psize;
+    t.color = pcolor;
+
+    vTexts.push_back(t);
+    return vTexts.size() - 1;
+}
+
+void GameEngine::SetText(int item, const std::string &pstr)
+{
+    if( !IsText(item) ) return;
+    TextItem &t = vTexts[item];
+    if( pstr == t.str ) return;
+    t.str = pstr;
+    t.text.setString(pstr);
+}
+
+void GameEngine::SetTextStyle(int item, sf::Color pcolor, int psize)
+{
+    if( !IsText(item) ) return;
+    TextItem &t = vTexts[item];
+    if( pcolor != t.color )
+    {
+        t.color = pcolor;
+        t.text.setFillColor(pcolor);
+    }
+    if( psize != t.size )
+    {
+        t.size = psize;
+        t.text.setCharacterSize(psize);
+    }
+}
+
+//the texts point to the fonts, they go away with them
+void GameEngine::CleanupTexts()
+{
+    vTexts.clear();
 }
 
 void GameEngine::loadAssets()
 {
-    std::ifstream in("assets/assets.txt");
-    if(in.good())
+    StartLoadingAssets();
+    if( loaderPool != nullptr ) loaderPool->Wait();
+    UploadAssets();
+}
+
+//decodes an image or a sound in a worker, without touching the video or the sound card
+void DecodeAsset(PendingAsset *p)
+{
+    if( p->datatype == "img" )
+    {
+        if( p->data != nullptr ) p->ok = p->image.image.loadFromMemory(p->data, p->size);
+        else p->ok = p->image.image.loadFromFile(p->filename);
+    }
+    if( p->datatype == "snd" )
+    {
+        sf::InputSoundFile file;
+        p->ok = (p->data != nullptr) ? file.openFromMemory(p->data, p->size) : file.openFromFile(p->filename);
+        if( p->ok )
+        {
+            p->samples.resize(file.getSampleCount());
+            p->samples.resize(file.read(p->samples.data(), p->samples.size()));
+            p->channels = file.getChannelCount();
+            p->sampleRate = file.getSampleRate();
+        }
+    }
+    p->ready.store(true, std::memory_order_release);
+}
+
+void GameEngine::StartLoadingAssets(const std::string &first)
+{
+    CancelLoading();
+    loadingFinished = false;
+
+    PendingAsset *firstAsset = nullptr;
+    auto addAsset = [&](const std::string &datatype, const std::string &name, const std::string &filename,
+                        const std::string &options, const unsigned char *data, size_t size)
+    {
+        //fonts and music only open the file, the data is read when it's used
+        if( datatype == "mus" )
+        {
+            if( data != nullptr ) openMusic(name, data, size);
+            else openMusic(name, filename);
+        }
+        if( datatype == "fnt" )
+        {
+            if( data != nullptr ) loadFont(name, data, size);
+            else loadFont(name, filename);
+        }
+        if( datatype != "img" && datatype != "snd" ) return;
+
+        PendingAsset *p = new PendingAsset();
+        p->datatype = datatype;
+        p->name = name;
+        p->filename = filename;
+        p->data = data;
+        p->size = size;
+        p->atlas = (options == "atlas");
+        p->image.name = name;
+        p->channels = p->sampleRate = 0;
+        p->ok = p->uploaded = false;
+        p->ready = false;
+        vPending.push_back(p);
+
+        if( name == first ) firstAsset = p;
+    };
+
+    //everything is in the archive if there is one, it's mapped and the assets are used from memory.
+    //it stays open, the fonts and the music read from it all the time
+    if( archive.IsOpen() || archive.Open(assetarchivefile) )
+    {
+        for(int i=0;i<archive.GetCount();i++)
+        {
+            const ArchiveEntry &e = archive.GetEntry(i);
+            addAsset(e.datatype, e.name, assetarchivefile + ":" + e.name, e.options, archive.GetData(i), e.size);
+        }
+    }
+    else
     {
+        std::ifstream in("assets/assets.txt");
+        if( !in.good() )
+        {
+            //nothing to wait for, the game goes on without the assets
+            std::cout << "Error loading assets" << std::endl;
+            ReportMissingAssets();
+            loadingFinished = true;
+            return;
+        }
+
         std::string str;
         while( std::getline(in,str) )
         {
             std::stringstream ss(str);
-            std::string datatype, name, filename;
+            std::string datatype, name, filename, options;
             ss>>datatype;
             ss>>name;
             ss>>filename;
-
-            if( datatype == "img" ) loadTexture(name, "assets/img/" + filename);
-            if( datatype == "snd" ) loadSoundBuffer(name, "assets/snd/" + filename);
-            if( datatype == "mus" ) openMusic(name, "assets/mus/" + filename);
-            if( datatype == "fnt" ) loadFont(name, "assets/fnt/" + filename);
+            ss>>options;
+            addAsset(datatype, name, "assets/" + datatype + "/" + filename, options, nullptr, 0);
         }
         in.close();
     }
-    else
+
+    //the images and sounds are decoded in parallel, the first one in this thread
+    //so it doesn't wait behind the others
+    loaderPool = new ThreadPool();
+    for(size_t i=0;i<vPending.size();i++)
+    {
+        PendingAsset *p = vPending[i];
+        if( p != firstAsset ) loaderPool->Submit([p](int) { DecodeAsset(p); });
+    }
+    if( firstAsset != nullptr )
+    {
+        DecodeAsset(firstAsset);
+        UploadAssets();
+    }
+}
+
+bool GameEngine::UploadAssets()
+{
+    if( loaderPool == nullptr ) return true;
+
+    bool all = true;
+    for(size_t i=0;i<vPending.size();i++)
+    {
+        PendingAsset *p = vPending[i];
+        if( p->uploaded ) continue;
+        if( !p->ready.load(std::memory_order_acquire) )
+        {
+            all = false;
+            continue;
+        }
+
+        p->uploaded = true;
+        if( !p->ok )
+        {
+            std::cout << "Error loading " << p->filename << std::endl;
+            continue;
+        }
+        if( p->atlas ) continue;  //they are packed when all of them are there
+
+        //the texture or the buffer is made in its place in the table, nothing is copied
+        if( p->datatype == "img" )
+        {
+            sf::Texture &t = mTextures.Create(mTextures.Intern(p->name));
+            if( !t.loadFromImage(p->image.image) ) std::cout << "Error creating texture " << p->name << std::endl;
+            sf::Vector2u size = t.getSize();
+            mRegions.Create(mRegions.Intern(p->name)) = TextureRegion{&t, sf::IntRect(0, 0, size.x, size.y)};
+            p->image.image = sf::Image();  //the pixels aren't needed anymore
+        }
+        if( p->datatype == "snd" )
+        {
+            SoundAsset &sa = mSounds.Create(mSounds.Intern(p->name));
+            if( !sa.buffer.loadFromSamples(p->samples.data(), p->samples.size(), p->channels, p->sampleRate) )
+                std::cout << "Error creating sound " << p->name << std::endl;
+            sa.sound.setBuffer(sa.buffer);
+            std::vector<sf::Int16>().swap(p->samples);
+        }
+    }
+    if( !all ) return false;
+
+    //everything is decoded, the atlas can be made now
+    std::vector<const AtlasImage*> atlasImages;
+    for(size_t i=0;i<vPending.size();i++)
+        if( vPending[i]->atlas && vPending[i]->ok ) atlasImages.push_back(&vPending[i]->image);
+    BuildAtlas(atlasImages);
+
+    CancelLoading();
+    ReportMissingAssets();
+    loadingFinished = true;
+
+    //the layers are painted with the assets
+    InvalidateLayers();
+    return true;
+}
+
+//the loading can end in StartLoadingAssets, before the main loop sees it
+bool GameEngine::LoadingFinished()
+{
+    if( !loadingFinished ) return false;
+    loadingFinished = false;
+    return true;
+}
+
+//the names are told once here, not every time a handle without an asset is used
+template<class T> void ReportMissing(AssetTable<T> &table, const std::string &kind)
+{
+    for(int i=0;i<table.GetCount();i++)
     {
-        std::cout << "Error loading assets" << std::endl;
+        AssetHandle<T> h(i);
+        if( !table.IsLoaded(h) ) std::cout << "Error " << kind << " " << table.GetName(h) << " not loaded" << std::endl;
     }
 }
 
+void GameEngine::ReportMissingAssets()
+{
+    ReportMissing(mRegions, "texture");
+    ReportMissing(mSounds, "sound");
+    ReportMissing(mMusic, "music");
+    ReportMissing(mFonts, "font");
+}
+
+void GameEngine::CancelLoading()
+{
+    if( loaderPool == nullptr ) return;
+
+    //the pool finishes the files it has before it stops
+    delete loaderPool;
+    loaderPool = nullptr;
+    for(size_t i=0;i<vPending.size();i++) delete vPending[i];
+    vPending.clear();
+}
+
 void GameEngine::CleanupAll()
 {
+    StopRenderThread();
+    StopInputThread();
+    CancelLoading();
     CleanupSprites();
+    CleanupLayers();
     CleanupTextures();
     CleanupSounds();
     CleanupMusic();
+    CleanupTexts();
     CleanupFonts();
+    archive.Close();
 }
 
 //-----------------------------------------------------------------
@@ -374,8 +1040,8 @@ bool GameEngine::CheckSpriteCollision(CSprite* pTestSprite)
   std::vector<CSprite*>::iterator siSprite;
   for (siSprite = vSprites.begin(); siSprite != vSprites.end(); siSprite++)
   {
-    // Make sure not to check for collision with itself
-    if (pTestSprite == (*siSprite))
+    // Make sure not to check for collision with itself or with a sprite killed in this update
+    if (pTestSprite == (*siSprite) || (*siSprite) == nullptr)
       continue;
 
     // Test the collision
@@ -390,90 +1056,90 @@ bool GameEngine::CheckSpriteCollision(CSprite* pTestSprite)
 
 void GameEngine::AddSprite(CSprite* pSprite)
 {
-    //add a sprite to the sprite vector
+    //add a sprite to the end of the sprite vector, it's put in its place by z-order before drawing
     if(pSprite != nullptr)
     {
-        //see if there are sprites already in the sprite vector
-        if(vSprites.size() > 0)
-        {
-            //find a spot in the sprite vector to insert the sprite by its z-order
-            std::vector<CSprite*>::iterator siSprite;
-            for(siSprite = vSprites.begin(); siSprite != vSprites.end(); siSprite++)
-                if(pSprite->GetZOrder() < (*siSprite)->GetZOrder())
-                {
-                    //insert the sprite into the sprite vector
-                    vSprites.insert(siSprite, pSprite);
-                    return;
-                }
-        }
-
-        // the sprite's z-order is highest, so add it to the end of the vector
         vSprites.push_back(pSprite);
+        spritesSorted = false;
     }
 }
 
-void GameEngine::DrawSprites(sf::RenderWindow &window)
+void GameEngine::SortSprites()
 {
-    //draw the sprites in the sprite vector
+    //the sprites with the same z-order stay in the order they were added
+    if( spritesSorted ) return;
+    std::stable_sort(vSprites.begin(), vSprites.end(), [](CSprite *a, CSprite *b) { return a->GetZOrder() < b->GetZOrder(); });
+    spritesSorted = true;
+}
+
+void GameEngine::DrawSprites(sf::RenderTarget &target)
+{
+    //draw the sprites in the sprite vector and then the ones in the pool
+    SortSprites();
     std::vector<CSprite*>::iterator siSprite;
     for(siSprite = vSprites.begin(); siSprite != vSprites.end(); siSprite++)
-        (*siSprite)->Draw(window);
+        (*siSprite)->Draw(target);
+    spritePool.Draw(target);
 }
 
 void GameEngine::UpdateSprites(sf::Time delta)
 {
-  // Update the sprites in the sprite vector
+  // Update the sprites in the sprite vector. the ones added now are updated
+  // the next time, and the killed ones are removed all at once at the end
   sf::FloatRect rcOldSpritePos;
   SPRITEACTION  saSpriteAction;
-  std::vector<CSprite*>::iterator siSprite;
-  for (siSprite = vSprites.begin(); siSprite != vSprites.end(); siSprite++)
+  size_t count = vSprites.size();
+  for (size_t i = 0; i < count; i++)
   {
+    CSprite *pSprite = vSprites[i];
+
     // Save the old sprite position in case we need to restore it
-    rcOldSpritePos = (*siSprite)->GetPosition();
+    rcOldSpritePos = pSprite->GetPosition();
 
     // Update the sprite
-    saSpriteAction = (*siSprite)->Update(delta);
+    saSpriteAction = pSprite->Update(delta);
 
     // handle the SA_ADDSPRITE sprite action
     if( saSpriteAction & SA_ADDSPRITE )
         //allow the sprite to add its sprite
-        AddSprite((*siSprite)->AddSprite());
+        AddSprite(pSprite->AddSprite());
 
     // Handle the SA_KILL sprite action
     if (saSpriteAction & SA_KILL)
     {
       //notify the game that the sprite is dying
-      SpriteDying(*siSprite);
+      SpriteDying(pSprite);
 
       //kill the sprite
-      delete (*siSprite);
-      vSprites.erase(siSprite);
-      siSprite--;
+      delete pSprite;
+      vSprites[i] = nullptr;
       continue;
     }
 
     // See if the sprite collided with any others
-    if (CheckSpriteCollision(*siSprite))
+    if (CheckSpriteCollision(pSprite))
       // Restore the old sprite position
-      (*siSprite)->SetPosition(rcOldSpritePos);
+      pSprite->SetPosition(rcOldSpritePos);
   }
+  vSprites.erase(std::remove(vSprites.begin(), vSprites.end(), (CSprite*)nullptr), vSprites.end());
+
+  spritePool.Update(delta);
 }
 
 void GameEngine::CleanupSprites()
 {
   // Delete and remove the sprites in the sprite vector
-  std::vector<CSprite*>::iterator siSprite;
-  for (siSprite = vSprites.begin(); siSprite != vSprites.end(); siSprite++)
-  {
-    delete (*siSprite);
-    vSprites.erase(siSprite);
-    siSprite--;
-  }
+  for (size_t i = 0; i < vSprites.size(); i++)
+    delete vSprites[i];
+  vSprites.clear();
+  spritesSorted = true;
+  spritePool.Clear();
 }
 
 CSprite* GameEngine::IsPointInSprite(float x, float y)
 {
   // See if the point is in a sprite in the sprite vector
+  SortSprites();
   std::vector<CSprite*>::reverse_iterator siSprite;
   for (siSprite = vSprites.rbegin(); siSprite != vSprites.rend(); siSprite++)
     if (!(*siSprite)->IsHidden() && (*siSprite)->IsPointInside(x, y))
@@ -485,7 +1151,10 @@ CSprite* GameEngine::IsPointInSprite(float x, float y)
 
 
 
-int main()
+//the tools that use the game code without playing it define TETRIS_NO_MAIN
+#ifndef TETRIS_NO_MAIN
+//usage: Tetris [-vsync | -uncapped | -fps n] [-pollkeys | -inputthread] [-renderthread]   the default is the game's frame limit
+int main(int argc, char *argv[])
 {
     sf::Clock clock;
     sf::Time timePerFrame = sf::seconds(1.f / 60.f); //default
@@ -493,6 +1162,23 @@ int main()
 
     if( GameInitialize() )
     {
+        //frame pacing and keyboard from the command line
+        FramePacer &pacer = GameEngine::GetEngine()->pacer;
+        for(int i=1;i<argc;i++)
+        {
+            std::string arg = argv[i];
+            if( arg == "-vsync" ) pacer.SetMode(PACE_VSYNC);
+            else if( arg == "-uncapped" ) pacer.SetMode(PACE_UNCAPPED);
+            else if( arg == "-fps" && i + 1 < argc )
+            {
+                pacer.SetMode(PACE_LIMIT);
+                pacer.SetFrameRate(std::max(1, atoi(argv[++i])));
+            }
+            else if( arg == "-pollkeys" ) GameEngine::GetEngine()->SetKeyPolling(true);
+            else if( arg == "-inputthread" ) GameEngine::GetEngine()->SetThreadedInput(true);
+            else if( arg == "-renderthread" ) GameEngine::GetEngine()->SetThreadedRender(true);
+        }
+
         //initialize the game engine
         if( !GameEngine::GetEngine()->Initialize() )
             return false;
@@ -506,23 +1192,81 @@ int main()
         // enter the main loop
         while( GameEngine::GetEngine()->running )
         {
-            elapsed += clock.restart();
+            //when nothing moves on the screen it waits for events instead of spinning,
+            //only a little while the assets are loading
+            sf::Time wait = sf::Time::Zero;
+            if( GameEngine::GetEngine()->IsRendering() )
+            {
+                //the render thread draws, this one waits for the events until the next cycle
+                if( GameEngine::GetEngine()->GetSleep() ) wait = GameEngine::GetEngine()->GetIdleWait();
+                else wait = timePerFrame - elapsed - clock.getElapsedTime();
+            }
+            else if( GameEngine::GetEngine()->IsIdle() )
+                wait = GameEngine::GetEngine()->IsLoading() ? sf::milliseconds(5) : GameEngine::GetEngine()->GetIdleWait();
+            GameEngine::GetEngine()->HandleEvents(GameEngine::GetEngine()->window, wait);
+
+            //the assets decoded in the background go to the video and sound cards here
+            if( GameEngine::GetEngine()->IsLoading() ) GameEngine::GetEngine()->UploadAssets();
+            if( GameEngine::GetEngine()->LoadingFinished() )
+            {
+                GameAssetsLoaded();
+                GameEngine::GetEngine()->Redraw();
+            }
 
-            GameEngine::GetEngine()->HandleEvents(GameEngine::GetEngine()->window);
             HandleKeys();
 
+            //sf::Time counts whole microseconds, so the cycles don't drift
+            elapsed += clock.restart();
+
             //check if the game engine is sleeping
             if( !GameEngine::GetEngine()->GetSleep() )
             {
-                while( elapsed >= timePerFrame )
+                //run the game at a fixed rate, a few cycles at most per frame.
+                //every cycle ends a time per frame after the last one, the game
+                //takes the keys pressed before then
+                sf::Time tickTime = GameEngine::GetEngine()->GetTime() - elapsed;
+                int cycles = 0;
+                while( elapsed >= timePerFrame && cycles < GameEngine::GetEngine()->GetMaxCatchUp() )
                 {
-                    GameCycle(elapsed);
+                    tickTime += timePerFrame;
+                    GameEngine::GetEngine()->SetTickTime(tickTime);
+                    GameCycle(timePerFrame);
                     elapsed -= timePerFrame;
+                    cycles++;
                 }
+
+                //if it's too far behind forget the rest, the game slows down instead of stalling
+                if( elapsed >= timePerFrame ) elapsed = timePerFrame - sf::microseconds(1);
             }
+            else elapsed = sf::Time::Zero;
 
-            GamePaint(GameEngine::GetEngine()->window);
+            //the render thread starts when there's something to draw
+            GamePublish();
+            if( GameEngine::GetEngine()->GetThreadedRender() && !GameEngine::GetEngine()->IsLoading() )
+                GameEngine::GetEngine()->StartRenderThread();
+
+            if( GameEngine::GetEngine()->IsRendering() )
+            {
+                GameEngine::GetEngine()->RequestFrames();
+                continue;
+            }
+
+            if( GameEngine::GetEngine()->NeedsRedraw() )
+            {
+                GamePaint(GameEngine::GetEngine()->window, elapsed / timePerFrame);
+                pacer.Wait();
+                GameEngine::GetEngine()->window.display();
+                pacer.FrameDone();
+                GameEngine::GetEngine()->SetRedraw(false);
+            }
+            else pacer.Skip();
         }
+
+        //the window is used again in this thread
+        GameEngine::GetEngine()->StopRenderThread();
+
+        //how regular the frames were
+        pacer.Report(std::cout);
     }
 
     //end the game
@@ -530,4 +1274,4 @@ int main()
 
     return EXIT_SUCCESS;
 }
-
+#endif // TETRIS_NO_MAIN
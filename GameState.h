@@ -0,0 +1,465 @@
+//headless game rules. this file doesn't depend on SFML so it can be used
+//by the game and by any tool that needs to run games without a window.
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include <algorithm>
+#include <cstring>
+
+#include "PieceGen.h"
+
+const int boardheight = 20;
+const int boardwidth = 10;
+
+//the board is one bitmask per row, bit (x + wallbits) is set if the cell is used.
+//the bits at both sides of the playfield are always set so the walls collide like
+//any other block. there are spare rows above (open) and below (solid) the board
+//so a piece can be tested anywhere near the board without bounds checks.
+typedef unsigned short rowmask;
+const int wallbits = 3;
+const int boardtop = 4;
+const int boardbottom = 4;
+const rowmask fullrow = 0xFFFF;
+const rowmask emptyrow = fullrow & ~(((1 << boardwidth) - 1) << wallbits);
+
+//the game runs at a fixed rate of ticks per second and one call to Step is one tick
+const int tickrate = 30;
+
+//input bits for one step of the game
+enum GAMEINPUT {IN_NONE = 0, IN_LEFT = 1, IN_RIGHT = 2, IN_ROTATE = 4, IN_DOWN = 8};
+
+struct Point{
+    int x,y;
+};
+
+//figures are 8 rows x 2 columns
+constexpr int figures[7][4] =
+{
+	{1,3,5,7}, // I
+	{2,4,5,7}, // Z
+	{3,5,4,6}, // S
+	{3,5,4,7}, // T
+	{2,3,5,7}, // L
+	{3,5,7,6}, // J
+	{2,3,4,5}, // O
+};
+
+//one rotation of a figure. the cells are relative to the second cell, which is
+//the center of rotation, top/left/width/height is the bounding box and masks
+//holds the row masks of the piece starting at row top and column left.
+struct PieceShape{
+    Point cells[4];
+    int top, left, width, height;
+    rowmask masks[4];
+};
+
+//a figure in one of its rotations with its center at x,y
+struct Piece{
+    int n, r;
+    int x, y;
+};
+
+//offsets tried in order when a piece rotates from rotation r to r + 1
+const int maxkicks = 6;
+struct KickTable{
+    int count;
+    Point offsets[maxkicks];
+};
+
+//every table about the pieces, generated at compile time from the figures table
+struct PieceTables{
+    PieceShape shapes[7][4];
+    Piece spawns[7];
+    KickTable kicks[7][4];
+};
+
+constexpr PieceTables MakePieceTables()
+{
+    PieceTables t{};
+    for(int n=0;n<7;n++)
+    {
+        //decode the figure and make the cells relative to the center of rotation
+        Point cells[4] = {};
+        for(int i=0;i<4;i++)
+        {
+            cells[i].x = figures[n][i] % 2 - figures[n][1] % 2;
+            cells[i].y = figures[n][i] / 2 - figures[n][1] / 2;
+        }
+
+        //new pieces appear with the cells where the figures table puts them
+        t.spawns[n] = Piece{n, 0, figures[n][1] % 2, figures[n][1] / 2};
+
+        for(int r=0;r<4;r++)
+        {
+            PieceShape &sh = t.shapes[n][r];
+            int bottom = -4, right = -4;
+            sh.top = 4; sh.left = 4;
+            for(int i=0;i<4;i++)
+            {
+                sh.cells[i] = cells[i];
+                if( cells[i].y < sh.top ) sh.top = cells[i].y;
+                if( cells[i].x < sh.left ) sh.left = cells[i].x;
+                if( cells[i].y > bottom ) bottom = cells[i].y;
+                if( cells[i].x > right ) right = cells[i].x;
+            }
+            sh.width = right - sh.left + 1;
+            sh.height = bottom - sh.top + 1;
+
+            for(int i=0;i<4;i++)
+                sh.masks[cells[i].y - sh.top] |= 1 << (cells[i].x - sh.left);
+
+            //next rotation, 90 degrees around the center
+            for(int i=0;i<4;i++)
+            {
+                int x = cells[i].x;
+                cells[i].x = -cells[i].y;
+                cells[i].y = x;
+            }
+        }
+
+        //kicks: in place first, then sideways one cell at a time up to the
+        //width of the rotated piece minus one, left before right, and last up.
+        //a kick never takes the cells past the walls of the row, a piece that
+        //fits before rotating can always be tested after the kick
+        for(int r=0;r<4;r++)
+        {
+            const PieceShape &from = t.shapes[n][r];
+            const PieceShape &to = t.shapes[n][(r + 1) % 4];
+            KickTable &k = t.kicks[n][r];
+            int reach = to.width - 1;
+            int leftroom = wallbits + to.left - from.left;
+            int rightroom = wallbits + (from.left + from.width) - (to.left + to.width);
+            if( reach > leftroom ) reach = leftroom;
+            if( reach > rightroom ) reach = rightroom;
+            if( reach < 1 ) reach = 1;
+            if( reach > (maxkicks - 2) / 2 ) reach = (maxkicks - 2) / 2;
+            k.offsets[k.count++] = Point{0, 0};
+            for(int d=1;d<=reach;d++)
+            {
+                k.offsets[k.count++] = Point{-d, 0};
+                k.offsets[k.count++] = Point{d, 0};
+            }
+            k.offsets[k.count++] = Point{0, -1};
+        }
+    }
+    return t;
+}
+
+constexpr PieceTables pieceTables = MakePieceTables();
+constexpr const PieceShape (&shapes)[7][4] = pieceTables.shapes;
+constexpr const Piece (&spawns)[7] = pieceTables.spawns;
+constexpr const KickTable (&kicks)[7][4] = pieceTables.kicks;
+
+//the shape tables must agree with the figures table
+static_assert(pieceTables.shapes[0][0].height == 4 && pieceTables.shapes[0][1].width == 4, "I piece");
+static_assert(pieceTables.shapes[6][0].masks[0] == 3 && pieceTables.shapes[6][0].masks[1] == 3, "O piece");
+
+//PieceFits shifts the masks by the column: a negative shift is undefined and
+//bits past the row never collide. every kick of a piece that fits before
+//rotating, at either wall, must keep the shift in the row
+constexpr bool KicksStayInRows(const PieceTables &t)
+{
+    for(int n=0;n<7;n++)
+        for(int r=0;r<4;r++)
+        {
+            const PieceShape &from = t.shapes[n][r];
+            const PieceShape &to = t.shapes[n][(r + 1) % 4];
+            const KickTable &k = t.kicks[n][r];
+            for(int i=0;i<k.count;i++)
+            {
+                int leftx = -from.left;                               //at the left wall
+                int rightx = boardwidth - from.left - from.width;     //at the right wall
+                int minshift = leftx + k.offsets[i].x + to.left + wallbits;
+                int maxbit = rightx + k.offsets[i].x + to.left + to.width - 1 + wallbits;
+                if( minshift < 0 || maxbit >= (int)sizeof(rowmask) * 8 ) return false;
+            }
+        }
+    return true;
+}
+static_assert(KicksStayInRows(pieceTables), "the kicks stay in the row");
+
+//returns true if the piece doesn't hit a wall, the floor or a used cell
+//of the board rows (rows starts at the first spare row above the board)
+inline bool PieceFits(const rowmask *rows, const Piece &p)
+{
+    const PieceShape &sh = shapes[p.n][p.r];
+
+    //the spare rows above are open, a piece kicked up past them doesn't fit
+    if (p.y + sh.top < -boardtop) return false;
+
+    const rowmask *row = &rows[boardtop + p.y + sh.top];
+    int shift = p.x + sh.left + wallbits;
+
+    rowmask hit = 0;
+    for (int i=0;i<sh.height;i++)
+        hit |= row[i] & (sh.masks[i] << shift);
+
+    return hit == 0;
+}
+
+//sets the cells of the piece in the board rows, the rows out of the board are not stored
+inline void PlacePiece(rowmask *rows, const Piece &p)
+{
+    const PieceShape &sh = shapes[p.n][p.r];
+    int top = p.y + sh.top;
+    int shift = p.x + sh.left + wallbits;
+
+    for (int i=0;i<sh.height;i++)
+        if (top + i >= 0 && top + i < boardheight)
+            rows[boardtop + top + i] |= sh.masks[i] << shift;
+}
+
+//what the last line clear did
+struct ClearStats{
+    int lines;  //rows cleared
+    int top;    //first row cleared
+    int moved;  //rows moved down
+    int shift;  //how far the rows above the cleared ones went down
+};
+
+class GameState
+{
+public:
+    rowmask rows[boardtop + boardheight + boardbottom];
+    //color of every cell of the board, only used to draw it
+    int colors[boardheight][boardwidth];
+    //goes up every time the board changes, so it's only redrawn then
+    unsigned int boardVersion;
+
+    //the actual piece and its color
+    Piece piece;
+    int colorNum;
+
+    //how many entries of the kick tables are tried when rotating,
+    //1 only tries the piece in place like the original rules
+    int rotationKicks;
+
+    //ticks for the piece to go one row down, normally and with down pressed
+    int gravityTicks;
+    int softDropTicks;
+
+    //7-bag pieces instead of the original uniform random ones
+    bool bag;
+
+    int score;
+    int lines;
+    int pieces;
+    bool over;
+
+    //lines cleared by the last call to Step
+    ClearStats cleared;
+
+    //ticks since the piece went down and ticks it needs with the last input
+    int ticks;
+    int dropTicks;
+    PieceGenerator gen;
+
+    GameState();
+
+    //general methods
+    void NewGame(uint64 seed, uint64 gameid = 0);
+    void DefaultRules();  //the original rules, a replay can bring others
+    void Step(unsigned int input);
+    float GetFallFraction(float alpha) const;
+    bool Valid(const Piece &p) const;
+    bool Move(int dx);
+    bool Rotate();
+    void Lock(const Piece &p, int color);
+    void NewPiece();
+    void ClearLines(int top, int height);
+};
+
+GameState::GameState()
+{
+    DefaultRules();
+    boardVersion = 0;
+    NewGame(0);
+}
+
+void GameState::DefaultRules()
+{
+    rotationKicks = 1;
+    gravityTicks = 10;  //0.3 seconds
+    softDropTicks = 2;  //0.05 seconds
+    bag = false;
+}
+
+void GameState::NewGame(uint64 seed, uint64 gameid)
+{
+    gen.Reset(seed, gameid, bag);
+    score = 0;
+    lines = 0;
+    pieces = 0;
+    over = false;
+    cleared = ClearStats();
+    ticks = 0;
+    dropTicks = gravityTicks;
+    colorNum = 1;
+
+    //the first piece is always an L
+    piece = spawns[4];
+
+    for(int i=0;i<boardtop;i++) rows[i] = emptyrow;
+    for(int i=0;i<boardheight;i++) rows[boardtop + i] = emptyrow;
+    for(int i=0;i<boardbottom;i++) rows[boardtop + boardheight + i] = fullrow;
+
+    for(int i=0;i<boardheight;i++)
+        for(int j=0;j<boardwidth;j++)
+            colors[i][j] = 0;
+    boardVersion++;
+}
+
+void GameState::Step(unsigned int input)
+{
+    cleared = ClearStats();
+    if( over ) return;
+
+    ticks++;
+
+    //// <- Move -> ///
+    int dx = ((input & IN_RIGHT) ? 1 : 0) - ((input & IN_LEFT) ? 1 : 0);
+    if( dx != 0 ) Move(dx);
+
+    //////Rotate//////
+    if (input & IN_ROTATE) Rotate();
+
+    ///////Tick//////
+    //if down is pressed make it go faster
+    dropTicks = (input & IN_DOWN) ? softDropTicks : gravityTicks;
+    if (ticks >= dropTicks)
+    {
+        //one down
+        Piece p = piece;
+        p.y += 1;
+
+        //if not valid now is because it can't move down,
+        //so create a new piece.
+        if (!Valid(p))
+        {
+            //if any of the cells is occupied by a piece then we can't put more
+            //so end game.
+            if( !Valid(piece) ) over = true;
+
+            //only the rows of the locked piece can be full
+            Lock(piece, colorNum);
+            ClearLines(piece.y + shapes[piece.n][piece.r].top, shapes[piece.n][piece.r].height);
+            NewPiece();
+        }
+        else piece = p;
+
+        ticks = 0;
+    }
+}
+
+//how far the piece is from its row to the next one, alpha is the fraction of
+//tick since the last Step. it's 0 if the piece can't go down, so it doesn't sink.
+float GameState::GetFallFraction(float alpha) const
+{
+    Piece p = piece;
+    p.y += 1;
+    if( over || !Valid(p) ) return 0;
+    return std::min(1.f, (ticks + alpha) / dropTicks);
+}
+
+bool GameState::Valid(const Piece &p) const
+{
+    return PieceFits(rows, p);
+}
+
+//the piece is only moved if it is valid in the new place.
+bool GameState::Move(int dx)
+{
+    Piece p = piece;
+    p.x += dx;
+    if (!Valid(p)) return false;
+    piece = p;
+    return true;
+}
+
+//tries the kicks of the rotation in order until one is valid
+bool GameState::Rotate()
+{
+    const KickTable &k = kicks[piece.n][piece.r];
+    int count = std::min(rotationKicks, k.count);
+    for (int i=0;i<count;i++)
+    {
+        Piece p = piece;
+        p.r = (piece.r + 1) % 4;
+        p.x += k.offsets[i].x;
+        p.y += k.offsets[i].y;
+        if (Valid(p))
+        {
+            piece = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+void GameState::Lock(const Piece &p, int color)
+{
+    PlacePiece(rows, p);
+
+    const PieceShape &sh = shapes[p.n][p.r];
+    for (int i=0;i<4;i++)
+    {
+        int x = p.x + sh.cells[i].x;
+        int y = p.y + sh.cells[i].y;
+        if (y >= 0 && y < boardheight) colors[y][x] = color;
+    }
+    pieces++;
+    boardVersion++;
+}
+
+void GameState::NewPiece()
+{
+    NextPiece next = gen.Next();
+    colorNum = next.color;
+    piece = spawns[next.figure];
+}
+
+void GameState::ClearLines(int top, int height)
+{
+    //rows of the board covered by the piece
+    int bottom = std::min(top + height, boardheight) - 1;
+    top = std::max(top, 0);
+
+    int count = 0;
+    for (int i=top;i<=bottom;i++)
+        if (rows[boardtop + i] == fullrow) count++;
+    if (count == 0) return;
+
+    //compact the rows between the lowest and the highest full row
+    int first = -1, last = -1;
+    int k = bottom;
+    for (int i=bottom;i>=top;i--)
+    {
+        if (rows[boardtop + i] == fullrow)
+        {
+            if (last < 0) last = i;
+            first = i;
+            continue;
+        }
+        if (last < 0) { k--; continue; } //below the lowest full row nothing moves
+        rows[boardtop + k] = rows[boardtop + i];
+        std::memcpy(colors[k], colors[i], sizeof(colors[k]));
+        k--;
+    }
+
+    //the rows above go down in one block and the top is empty now
+    std::memmove(&rows[boardtop + count], &rows[boardtop], top * sizeof(rowmask));
+    std::memmove(colors[count], colors[0], top * sizeof(colors[0]));
+    for (int i=0;i<count;i++) rows[boardtop + i] = emptyrow;
+    std::memset(colors, 0, count * sizeof(colors[0]));
+
+    cleared.lines = count;
+    cleared.top = first;
+    cleared.moved = top + (last - top + 1 - count);
+    cleared.shift = count;
+
+    lines += count;
+    score += 40 * count;
+    boardVersion++;
+}
+
+#endif
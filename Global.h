@@ -1,34 +1,56 @@
+//a sound and the samples it plays
+struct SoundAsset{
+    sf::SoundBuffer buffer;
+    sf::Sound sound;
+};
+
+//the assets by handle, the names are only used to get the handles
+typedef AssetHandle<TextureRegion> TextureHandle;
+typedef AssetHandle<SoundAsset> SoundHandle;
+typedef AssetHandle<sf::Music> MusicHandle;
+typedef AssetHandle<sf::Font> FontHandle;
+
 //Textures
-std::map<std::string, sf::Texture> mTextures;
+AssetTable<sf::Texture> mTextures;
+//where every image is, in its own texture or in an atlas page
+AssetTable<TextureRegion> mRegions;
 //fonts
-std::map<std::string, sf::Font> mFonts;
-//Sound Buffers
-std::map<std::string, sf::SoundBuffer> mSoundBuffers;
+AssetTable<sf::Font> mFonts;
 //Sounds
-std::map<std::string, sf::Sound> mSounds;
+AssetTable<SoundAsset> mSounds;
 //Music
-std::map<std::string, sf::Music*> mMusic;
+AssetTable<sf::Music> mMusic;
+
+//the image of a sprite, in its own texture or a part of an atlas page. null
+//and an error if it isn't loaded
+TextureRegion *FindRegion(TextureHandle texture)
+{
+    TextureRegion *r = mRegions.Get(texture);
+    if( r == nullptr )
+        std::cout << "Error texture " << (texture.IsValid() ? mRegions.GetName(texture) : "") << " not loaded" << std::endl;
+    return r;
+}
 
+//random numbers for the effects, made with the same counter based generator as the pieces
 class Rnd{
 public:
-    std::mt19937 rng;
+    uint64 key;
+    uint64 counter;
 
     Rnd()
     {
-        std::mt19937 prng(std::chrono::steady_clock::now().time_since_epoch().count());
-        rng = prng;
+        key = MakeSquaresKey(std::chrono::steady_clock::now().time_since_epoch().count(), 0);
+        counter = 0;
     }
 
     int getRndInt(int min, int max)
     {
-        std::uniform_int_distribution<int> distribution(min, max);
-        return distribution(rng);
+        return min + RandomBelow(Squares32(counter++, key), max - min + 1);
     }
 
     double getRndDouble(double min, double max)
     {
-        std::uniform_real_distribution<double> distribution(min, max);
-        return distribution(rng);
+        return min + (max - min) * (Squares32(counter++, key) / 4294967296.0);
     }
 };
 
@@ -0,0 +1,146 @@
+//input queue. the key presses and releases of the game are kept with the
+//time they arrived, and every tick takes the ones that happened before its
+//end, in order. a tap is never lost or merged with another one: if a tick
+//already moved or rotated the piece, the next tap waits for the next tick.
+//holding left or right moves the piece once, then again after the delayed
+//auto shift and every auto repeat after that, by the time, not by the frames.
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+
+#include <ostream>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "GameState.h"
+#include "SampleStats.h"
+
+class InputQueue
+{
+public:
+    InputQueue();
+
+    //general methods
+    void Reset();  //forgets the keys, for a new game or when the bot takes over
+    void Push(unsigned int action, bool down, sf::Time time);  //action is one of the IN_ bits
+    unsigned int Tick(sf::Time tickTime, sf::Time now);  //the input of the tick that ends at tickTime, run at now
+    void Report(std::ostream &out);
+    void ResetStats() { latency.Reset(); };
+
+    //accessor methods
+    sf::Time GetDelayedAutoShift() { return das; };
+    void SetDelayedAutoShift(sf::Time tdas) { das = tdas; };
+    sf::Time GetAutoRepeatRate() { return arr; };
+    void SetAutoRepeatRate(sf::Time tarr) { arr = tarr; };  //zero repeats every tick
+
+protected:
+    struct Event{
+        unsigned int action;
+        bool down;
+        sf::Time time;
+    };
+    std::vector<Event> events;
+    size_t first;  //the events before it were taken
+
+    sf::Time das, arr;
+    bool leftHeld, rightHeld, downHeld;
+    unsigned int shift;  //IN_LEFT or IN_RIGHT while one of them is held, the last pressed
+    sf::Time nextShift;  //when it moves again by itself
+
+    SampleStats latency;  //time from the key to the tick that used it
+};
+
+InputQueue::InputQueue()
+{
+    das = sf::milliseconds(170);
+    arr = sf::milliseconds(50);
+    Reset();
+}
+
+void InputQueue::Reset()
+{
+    events.clear();
+    first = 0;
+    leftHeld = rightHeld = downHeld = false;
+    shift = IN_NONE;
+    nextShift = sf::Time::Zero;
+}
+
+void InputQueue::Push(unsigned int action, bool down, sf::Time time)
+{
+    //the taken ones are removed when there are enough of them
+    if( first > 0 && first * 2 >= events.size() )
+    {
+        events.erase(events.begin(), events.begin() + first);
+        first = 0;
+    }
+    events.push_back(Event{action, down, time});
+}
+
+unsigned int InputQueue::Tick(sf::Time tickTime, sf::Time now)
+{
+    unsigned int input = IN_NONE;
+    bool moved = false, rotated = false;
+
+    for( ; first < events.size() && events[first].time <= tickTime; first++ )
+    {
+        const Event &e = events[first];
+        bool move = (e.action == IN_LEFT || e.action == IN_RIGHT);
+
+        //one move and one rotation per tick, the rest wait in order
+        if( e.down && ((move && moved) || (e.action == IN_ROTATE && rotated)) ) break;
+
+        if( move )
+        {
+            bool &held = (e.action == IN_LEFT) ? leftHeld : rightHeld;
+            held = e.down;
+            if( e.down )
+            {
+                input = (input & ~(IN_LEFT | IN_RIGHT)) | e.action;
+                moved = true;
+                shift = e.action;
+                nextShift = e.time + das;
+            }
+            else if( shift == e.action )
+            {
+                //back to the other one if it's still held, with its delay again
+                shift = leftHeld ? IN_LEFT : (rightHeld ? IN_RIGHT : IN_NONE);
+                nextShift = e.time + das;
+            }
+        }
+        if( e.action == IN_ROTATE && e.down )
+        {
+            input |= IN_ROTATE;
+            rotated = true;
+        }
+        if( e.action == IN_DOWN )
+        {
+            downHeld = e.down;
+            if( e.down ) input |= IN_DOWN;  //a tap shorter than a tick still drops one tick faster
+        }
+
+        if( e.down ) latency.Add((now - e.time).asSeconds() * 1000.f);
+    }
+
+    if( downHeld ) input |= IN_DOWN;
+
+    //auto repeat, at most once per tick
+    if( shift != IN_NONE && !moved && nextShift <= tickTime )
+    {
+        input |= shift;
+        if( arr <= sf::Time::Zero ) nextShift = tickTime;
+        else while( nextShift <= tickTime ) nextShift += arr;
+    }
+    return input;
+}
+
+void InputQueue::Report(std::ostream &out)
+{
+    std::vector<float> times = latency.Sorted();
+    if( times.empty() ) return;
+
+    out << "key presses " << times.size() << std::endl;
+    PrintPercentiles(out, "input ms    ", times);
+}
+
+#endif
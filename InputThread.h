@@ -0,0 +1,114 @@
+//input thread. it reads the keys of the game every few milliseconds and
+//sends the changes with their time to the main thread through a ring, so
+//when a key was pressed doesn't depend on how long the main thread takes to
+//draw. SFML only gives the window events to the thread that made the window,
+//so the events stay in the main thread and this one asks for the keys
+//instead. every key asked for is a round trip to the window system, so it
+//only asks while it's active and not faster than the period.
+#ifndef INPUTTHREAD_H
+#define INPUTTHREAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <SFML/System.hpp>
+#include <SFML/Window.hpp>
+
+#include "SpscRing.h"
+
+//a key pressed or released and when it was seen
+struct KeyStroke{
+    sf::Keyboard::Key key;
+    bool down;
+    sf::Time time;
+};
+
+class InputThread
+{
+public:
+    InputThread();
+    ~InputThread() { Stop(); };
+
+    //general methods
+    void Start(const std::vector<sf::Keyboard::Key> &pkeys, const sf::Clock &pclock);  //the times are from pclock
+    void Stop();
+    bool Pop(KeyStroke &stroke) { return ring.Pop(stroke); };
+
+    //accessor methods
+    bool IsRunning() { return thread.joinable(); };
+    void SetActive(bool bactive) { active.store(bactive, std::memory_order_relaxed); };  //only while the window has the focus
+    sf::Time GetPeriod() { return period; };
+    void SetPeriod(sf::Time tperiod) { period = tperiod; };  //before Start
+    int GetDropped() { return dropped.load(std::memory_order_relaxed); };  //the ring was full
+
+private:
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> active;
+    std::atomic<int> dropped;
+    std::vector<sf::Keyboard::Key> keys;
+    std::vector<bool> down;
+    const sf::Clock *clock;
+    sf::Time period;
+    SpscRing<KeyStroke, 256> ring;
+
+    void ThreadLoop();
+};
+
+InputThread::InputThread()
+{
+    running = false;
+    active = true;
+    dropped = 0;
+    clock = nullptr;
+    period = sf::milliseconds(4);  //8 times per tick, 1000 questions a second for 4 keys
+}
+
+void InputThread::Start(const std::vector<sf::Keyboard::Key> &pkeys, const sf::Clock &pclock)
+{
+    Stop();
+    keys = pkeys;
+    down.assign(keys.size(), false);
+    clock = &pclock;
+    running = true;
+    thread = std::thread(&InputThread::ThreadLoop, this);
+}
+
+void InputThread::Stop()
+{
+    if( !thread.joinable() ) return;
+    running = false;
+    thread.join();
+}
+
+void InputThread::ThreadLoop()
+{
+    KeyStroke stroke;
+    while( running.load(std::memory_order_relaxed) )
+    {
+        bool isActive = active.load(std::memory_order_relaxed);
+        for(size_t i=0;i<keys.size();i++)
+        {
+            //without the focus the keys are for another window, they are released
+            bool isDown = isActive && sf::Keyboard::isKeyPressed(keys[i]);
+            if( isDown == down[i] ) continue;
+
+            stroke.key = keys[i];
+            stroke.down = isDown;
+            stroke.time = clock->getElapsedTime();
+            if( !ring.Push(stroke) )
+            {
+                //tried again next time
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            down[i] = isDown;
+        }
+        //inactive it only waits to be active again
+        sf::sleep(isActive ? period : std::max(period, sf::milliseconds(20)));
+    }
+}
+
+#endif
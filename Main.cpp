@@ -10,79 +10,150 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 
+#include "Atlas.h"
+#include "GameState.h"
+#include "Bot.h"
+#include "Replay.h"
+#include "ThreadPool.h"
+#include "AssetArchive.h"
+#include "AssetRegistry.h"
+#include "BoardRenderer.h"
+#include "FramePacer.h"
+#include "TripleBuffer.h"
+#include "InputQueue.h"
+#include "InputThread.h"
+
 //global common variables
-const int boardheight = 20;
-const int boardwidth = 10;
-int field[boardheight][boardwidth] = {0};
-int dx = 0;
-bool rotate = false;
-int colorNum = 1;
-float timer = 0;
-float delay = 0.3;
-sf::Clock cl;
-
-//a is the actual 4 points piece
-//b is a auxiliary array
-struct Point{
-    int x,y;
-} a[4], b[4];
-
-//figures are 8 rows x 2 columns
-int figures[7][4] =
-{
-	1,3,5,7, // I
-	2,4,5,7, // Z
-	3,5,4,6, // S
-	3,5,4,7, // T
-	2,3,5,7, // L
-	3,5,7,6, // J
-	2,3,4,5, // O
+GameState game;
+unsigned int input = IN_NONE;
+
+//the player's keys wait here with their time until the tick they belong to
+InputQueue inputQueue;
+
+//the keys of the game and what they do
+struct KeyBinding{
+    sf::Keyboard::Key key;
+    unsigned int action;
 };
+const KeyBinding gamekeys[] = {
+    {sf::Keyboard::Left, IN_LEFT},
+    {sf::Keyboard::Right, IN_RIGHT},
+    {sf::Keyboard::Up, IN_ROTATE},
+    {sf::Keyboard::Down, IN_DOWN}
+};
+
+//in autoplay mode the bot gives the input instead of the keyboard
+Bot bot;
+bool autoplay = false;
+
+//every game is recorded in a replay file, and it can be played again from the menu
+const std::string replayfile = "last.rpl";
+ReplayWriter recorder;
+ReplayReader player;
+int replaySpeed = 1;  //ticks per cycle, 0 plays the rest of the replay at once
 
-int score = -1;
-enum game_states {SPLASH, MENU, GAME, END_GAME};
+enum game_states {SPLASH, MENU, GAME, END_GAME, REPLAY};
 int state = SPLASH;
 std::vector<int> vhiscores;
 
+//what is drawn: a copy of the game after the cycles, made for every frame or
+//published for the render thread
+struct Snapshot{
+    int state;
+    GameState game;
+    bool autoplay;
+    int replaySpeed;
+    int hiscores[5];
+    sf::Time tickTime;  //when the last cycle ended
+    bool moving;  //the cycles are running, the piece falls between them
+};
+TripleBuffer<Snapshot> snapshots;
+Snapshot frame;  //without the render thread
+int publishedState = -1;  //the state of the last GamePublish
+
 #include "Global.h"
 #include "CSprite.h"
+#include "SpritePool.h"
 #include "Background.h"
 #include "GameEngine.h"
 
 //class variables
 GameEngine *pGame;
-CSprite* s;
+BoardRenderer board;
+
+//the assets, by handle
+TextureHandle splashTexture, menuTexture, backgroundTexture, frameTexture, tilesTexture;
+SoundHandle lineSound;
+MusicHandle music;
+FontHandle font;
+
+//static layers
+int splashLayer, menuLayer, backgroundLayer, frameLayer;
+
+//texts and the numbers they show now, the strings are only made again when the numbers change
+int scoreText = -1, autoText = -1, replayText = -1, gameOverText = -1, pressText = -1, hiscoresText = -1;  //-1 until the assets are loaded
+int shownScore, shownSpeed;
+int shownHiScores[5];  //in the menu layer
 
 //functions
-void NewGame();
-bool valid();
+uint64 NewGame();
+bool StartReplay(const std::string &filename);
+void GetAssetHandles();
+void CreateLayers();
+void CreateTexts();
+void TakeSnapshot(Snapshot &s);
+void DrawSnapshot(sf::RenderTarget &target, const Snapshot &s, float alpha);
 
 bool GameInitialize()
 {
     pGame = new GameEngine("Tetris",320,480);
     if(pGame == nullptr) return false;
 
-    pGame->SetFrameRate(30);
+    pGame->SetFrameRate(tickrate);
+    pGame->pacer.SetFrameRate(60);  //drawn twice per cycle, the piece falls smoothly between them
+
+    //holding left or right moves again after 170 ms and then every 50 ms
+    inputQueue.SetDelayedAutoShift(sf::milliseconds(170));
+    inputQueue.SetAutoRepeatRate(sf::milliseconds(50));
 
     return true;
 }
 
 void GameStart()
 {
-    pGame->loadAssets();
-    pGame->playMusic("music",true);
+    //the splash is shown while the rest of the assets load
+    GetAssetHandles();
+    pGame->StartLoadingAssets("splash");
+    CreateLayers();
 
-    sf::FloatRect rcBounds(0,0,pGame->GetWidth(), pGame->GetHeight());
-    s = new CSprite("tiles",rcBounds, BA_STOP);
+    board.SetPosition(28,31); //offset
+
+    //the keys of the game can be read in their own thread, the others come with the window events
+    if( pGame->GetThreadedInput() )
+    {
+        std::vector<sf::Keyboard::Key> keys;
+        for(const KeyBinding &b : gamekeys) keys.push_back(b.key);
+        pGame->SetThreadedInputWanted(false);  //until a game starts
+        pGame->StartInputThread(keys);
+    }
 
     ReadHiScores(vhiscores);
     NewGame();
 }
 
+void GameAssetsLoaded()
+{
+    pGame->playMusic(music,true);
+    CreateTexts();
+    board.SetTexture(pGame->getRegion(tilesTexture));
+}
+
 void GameEnd()
 {
+    recorder.Close();
     WriteHiScores(vhiscores);
-    pGame->stopMusic("music");
+    inputQueue.Report(std::cout);
+    pGame->stopMusic(music);
 
     pGame->CleanupAll();
     pGame->window.close();
@@ -91,159 +162,234 @@ void GameEnd()
 
 void GameActivate()
 {
-    pGame->continueMusic("music");
+    pGame->continueMusic(music);
 }
 
 void GameDeactivate()
 {
-    pGame->pauseMusic("music");
+    pGame->pauseMusic(music);
 }
 
-void GamePaint(sf::RenderWindow &window)
+void GamePaint(sf::RenderTarget &target, float alpha)
 {
-    window.clear();
+    //the render thread draws the last snapshot the cycles published, the
+    //fraction of cycle is from when it was made
+    if( pGame->IsRendering() )
+    {
+        const Snapshot &s = snapshots.Read();
+        alpha = 0;
+        if( s.moving ) alpha = std::max(0.f, std::min(1.f, (pGame->GetTime() - s.tickTime) / pGame->GetTimePerFrame()));
+        DrawSnapshot(target, s, alpha);
+        return;
+    }
 
-    switch(state)
+    TakeSnapshot(frame);
+    DrawSnapshot(target, frame, alpha);
+}
+
+void GamePublish()
+{
+    //only the game moves by itself, the other screens are drawn again when
+    //something happens. a new state is drawn once even without an event, like
+    //the game over screen after the last cycle of a game
+    bool moving = (state == GAME || state == REPLAY);
+    if( state != publishedState || moving != pGame->GetAnimating() ) pGame->Redraw();
+    publishedState = state;
+    pGame->SetAnimating(moving);
+
+    //the input thread only reads the keys while somebody plays
+    if( pGame->GetThreadedInput() ) pGame->SetThreadedInputWanted(state == GAME && !autoplay);
+
+    if( !pGame->GetThreadedRender() ) return;
+    TakeSnapshot(snapshots.Back());
+    snapshots.Publish();
+}
+
+void TakeSnapshot(Snapshot &s)
+{
+    s.state = state;
+    s.game = game;
+    s.autoplay = autoplay;
+    s.replaySpeed = replaySpeed;
+    for(int i=0;i<5;i++) s.hiscores[i] = vhiscores[i];
+    s.tickTime = pGame->GetTickTime();
+    s.moving = !pGame->GetSleep();
+}
+
+void DrawSnapshot(sf::RenderTarget &target, const Snapshot &s, float alpha)
+{
+    //the splash, menu and background layers cover the whole window, it
+    //only has to be cleared in the other states
+    switch(s.state)
     {
     case SPLASH:
-        pGame->showTexture("splash",0,0, window);
+        pGame->DrawLayer(splashLayer, target);
         break;
     case MENU:
+        //the layer is painted again when the scores change
+        if( !std::equal(s.hiscores, s.hiscores + 5, shownHiScores) )
         {
-            pGame->showTexture("menu",0,0, window);
-
-            //show hi scores
-            std::string histr="HI-SCORES\n";
-            for(int i=0;i<5;i++)
-            {
-                histr = histr + "     " + std::to_string(vhiscores[i]) + "\n";
-            }
-            pGame->Text(histr, 80, 240, sf::Color::Cyan, 20, "font", window);
-            break;
+            std::copy(s.hiscores, s.hiscores + 5, shownHiScores);
+            pGame->InvalidateLayer(menuLayer);
         }
+        pGame->DrawLayer(menuLayer, target);
+        break;
     case GAME:
+    case REPLAY:
         {
-            pGame->showTexture("background", 0,0, window);
-            //draw the field
-            for(int i=0;i<boardheight;i++)
-                for(int j=0;j<boardwidth; j++)
+            pGame->DrawLayer(backgroundLayer, target);
+            //draw the field and the actual piece, it falls smoothly between cycles
+            board.Update(s.game, s.game.GetFallFraction(alpha) * 18);
+            board.Draw(target);
+
+            pGame->DrawLayer(frameLayer, target);
+
+            //draw the score
+            if( s.game.score != shownScore )
             {
-                if(field[i][j]==0) continue;
-                s->SetTextureRect(sf::IntRect(field[i][j]*18,0,18,18));
-                s->SetPosition(j*18,i*18);
-                s->OffsetPosition(28,31); //offset
-                s->Draw(window);
+                shownScore = s.game.score;
+                pGame->SetText(scoreText, "SCORE:  \n" + std::to_string(s.game.score));
             }
-
-            //the actual piece
-            for(int i=0;i<4;i++)
+            pGame->DrawText(scoreText, target);
+            if( s.autoplay && s.state == GAME ) pGame->DrawText(autoText, target);
+            if( s.state == REPLAY )
             {
-                s->SetTextureRect(sf::IntRect(colorNum*18,0,18,18));
-                s->SetPosition(a[i].x*18,a[i].y*18);
-                s->OffsetPosition(28,31); //offset
-                s->Draw(window);
+                if( s.replaySpeed != shownSpeed )
+                {
+                    shownSpeed = s.replaySpeed;
+                    pGame->SetText(replayText, "REPLAY\nx" + std::to_string(s.replaySpeed));
+                }
+                pGame->DrawText(replayText, target);
             }
 
-            pGame->showTexture("frame",0,0,window);
-
-            //draw the score
-            std::string sc = "SCORE:  \n" + std::to_string(score);
-            pGame->Text(sc,240,20,sf::Color::Black, 20, "font", window);
-
-            //pGame->DrawSprites(window);
+            //pGame->DrawSprites(target);
             break;
         }
     case END_GAME:
         {
-            pGame->Text("GAME OVER", 100,30, sf::Color::Cyan, 25, "font", window);
-            pGame->Text("PRESS M", 100,100, sf::Color::Cyan, 25, "font", window);
+            target.clear();
+            pGame->DrawText(gameOverText, target);
+            pGame->DrawText(pressText, target);
             break;
         }
     default:
+        target.clear();
         break;
     }
-    window.display();
+}
+
+//-----------------------------------------------------------------
+// Assets
+//-----------------------------------------------------------------
+//the names are only looked up here, the handles are valid before the assets are loaded
+void GetAssetHandles()
+{
+    splashTexture = pGame->GetTextureHandle("splash");
+    menuTexture = pGame->GetTextureHandle("menu");
+    backgroundTexture = pGame->GetTextureHandle("background");
+    frameTexture = pGame->GetTextureHandle("frame");
+    tilesTexture = pGame->GetTextureHandle("tiles");
+    lineSound = pGame->GetSoundHandle("line");
+    music = pGame->GetMusicHandle("music");
+    font = pGame->GetFontHandle("font");
+}
+
+//-----------------------------------------------------------------
+// Layers
+//-----------------------------------------------------------------
+void PaintSplash(sf::RenderTarget &target)
+{
+    pGame->showTexture(splashTexture,0,0, target);
+}
+
+void PaintMenu(sf::RenderTarget &target)
+{
+    pGame->showTexture(menuTexture,0,0, target);
+
+    //show hi scores
+    std::string histr="HI-SCORES\n";
+    for(int i=0;i<5;i++)
+    {
+        histr = histr + "     " + std::to_string(shownHiScores[i]) + "\n";
+    }
+    pGame->SetText(hiscoresText, histr);
+    pGame->DrawText(hiscoresText, target);
+}
+
+void PaintBackground(sf::RenderTarget &target)
+{
+    pGame->showTexture(backgroundTexture,0,0, target);
+}
+
+void PaintFrame(sf::RenderTarget &target)
+{
+    pGame->showTexture(frameTexture,0,0, target);
+}
+
+void CreateLayers()
+{
+    splashLayer = pGame->CreateLayer(PaintSplash, true);
+    menuLayer = pGame->CreateLayer(PaintMenu, true);
+    backgroundLayer = pGame->CreateLayer(PaintBackground, true);
+    frameLayer = pGame->CreateLayer(PaintFrame, false);  //it goes over the board
+}
+
+//-----------------------------------------------------------------
+// Texts
+//-----------------------------------------------------------------
+void CreateTexts()
+{
+    scoreText = pGame->CreateText("", 240,20, sf::Color::Black, 20, font);
+    autoText = pGame->CreateText("AUTO", 240,80, sf::Color::Black, 20, font);
+    replayText = pGame->CreateText("", 240,80, sf::Color::Black, 20, font);
+    gameOverText = pGame->CreateText("GAME OVER", 100,30, sf::Color::Cyan, 25, font);
+    pressText = pGame->CreateText("PRESS M", 100,100, sf::Color::Cyan, 25, font);
+    hiscoresText = pGame->CreateText("", 80,240, sf::Color::Cyan, 20, font);
+
+    //made the first time they are drawn
+    shownScore = -1;
+    shownSpeed = -1;
 }
 
 void GameCycle(sf::Time delta)
 {
     if( state == GAME )
     {
-        float time = cl.getElapsedTime().asSeconds();
-        cl.restart();
-        timer+= time;
-
-        //// <- Move -> ///
-        //copy a to b and update a.
-        for (int i=0;i<4;i++)  { b[i] = a[i]; a[i].x += dx; }
-        //if a is not valid then get b again.
-        if (!valid()) for (int i=0;i<4;i++) a[i] = b[i];
-
-        //////Rotate//////
-        if (rotate)
-        {
-            Point p = a[1]; //center of rotation
-            for (int i=0;i<4;i++)
-              {
-                int x = a[i].y - p.y;
-                int y = a[i].x - p.x;
-                a[i].x = p.x - x;
-                a[i].y = p.y + y;
-              }
-            //if a is not valid get b again.
-            if (!valid()) for (int i=0;i<4;i++) a[i] = b[i];
-        }
+        //the player's keys until the end of this tick, the bot's input comes from HandleKeys
+        if( !autoplay ) input = inputQueue.Tick(pGame->GetTickTime(), pGame->GetTime());
 
-        ///////Tick//////
-        if (timer>delay)
-        {
-            //one down
-            for (int i=0;i<4;i++) { b[i] = a[i]; a[i].y += 1; }
+        recorder.Record(input);
+        game.Step(input);
 
-            //if not valid now is because it can't move down,
-            //so create a new piece.
-            if (!valid())
-            {
-                //if any of the cells is occupied by a piece then we can't put more
-                //so end game.
-                for(int i=0;i<4;i++) if( field[b[i].y][b[i].x] ) state = END_GAME;
-                if( state == END_GAME ) UpdateHiScores(vhiscores, score);
-
-                 for (int i=0;i<4;i++) field[b[i].y][b[i].x] = colorNum;
-
-                 colorNum = 1 + rand()%7; //get new color
-                 int n = rand()%7; //get new figure
-                 for (int i=0;i<4;i++)
-                 {
-                        a[i].x = figures[n][i] % 2;
-                        a[i].y = figures[n][i] / 2;
-                 }
-            }
+        if( game.cleared.lines > 0 ) pGame->playSound(lineSound);
 
-            timer = 0;
+        if( game.over )
+        {
+            state = END_GAME;
+            recorder.Close();
+            UpdateHiScores(vhiscores, game.score);
         }
 
-        ///////check lines//////////
-        int k = boardheight - 1;
-        for (int i = boardheight-1;i>0;i--)
+        //restore default values
+        input = IN_NONE;
+    }
+    else if( state == REPLAY )
+    {
+        //several ticks per cycle to play it faster, or all of them
+        unsigned int tickinput;
+        bool line = false;
+        for(int i=0;i<replaySpeed || replaySpeed == 0;i++)
         {
-            int count=0;
-            for (int j=0;j<boardwidth;j++)
-            {
-                //if there is part of a piece there
-                if (field[i][j]) count++;
-                field[k][j] = field[i][j];
-            }
-            if (count<boardwidth) k--;
-            else
+            if( game.over || !player.Next(tickinput) )
             {
-                pGame->playSound("line");
-                score += 40;
+                state = END_GAME;
+                player.Close();
+                break;
             }
+            game.Step(tickinput);
+            if( game.cleared.lines > 0 ) line = true;
         }
-
-        //restore default values
-        dx=0; rotate=0; delay=0.3;
+        if( line ) pGame->playSound(lineSound);
     }
 }
 
@@ -253,29 +399,48 @@ void HandleKeys()
     {
     case SPLASH:
         {
-            if( pGame->KeyPressed(sf::Keyboard::Space)) state = MENU;
+            if( pGame->KeyPressed(sf::Keyboard::Space) && !pGame->IsLoading() ) state = MENU;
             break;
         }
     case MENU:
         {
-            if( pGame->KeyPressed(sf::Keyboard::S) )
+            //S to play, B to watch the bot play, R to watch the last game again
+            if( pGame->KeyPressed(sf::Keyboard::S) || pGame->KeyPressed(sf::Keyboard::B) )
             {
                 state = GAME;
-                NewGame();
+                autoplay = pGame->KeyPressed(sf::Keyboard::B);
+
+                //only the games played are recorded, the last replay stays until then
+                uint64 seed = NewGame();
+                recorder.Open(replayfile, seed, 0, game);
+            }
+            else if( pGame->KeyPressed(sf::Keyboard::R) )
+            {
+                if( StartReplay(replayfile) ) state = REPLAY;
             }
             break;
         }
     case GAME:
         {
-        //space is the fire key
-        if( pGame->KeyPressed(sf::Keyboard::Up) )
-            rotate = true;
-        else if( pGame->KeyPressed(sf::Keyboard::Left))
-            dx = -1;
-        else if( pGame->KeyPressed(sf::Keyboard::Right)) dx = 1;
-
-        //if down arrow is pressed make it go faster
-        if( pGame->KeyPressed(sf::Keyboard::Down) || pGame->KeyHeld(sf::Keyboard::Down)) delay = 0.05;
+        //B switches the bot on and off
+        if( pGame->KeyPressed(sf::Keyboard::B) )
+        {
+            autoplay = !autoplay;
+            bot.Reset();
+            inputQueue.Reset();
+        }
+
+        if( autoplay )
+        {
+            input = bot.GetInput(game);
+            break;
+        }
+
+        //the keys go to the queue in the order they came, the cycles take them
+        const std::vector<KeyStroke> &strokes = pGame->GetKeyStrokes();
+        for(size_t i=0;i<strokes.size();i++)
+            for(const KeyBinding &b : gamekeys)
+                if( strokes[i].key == b.key ) inputQueue.Push(b.action, strokes[i].down, strokes[i].time);
         break;
         }
     case END_GAME:
@@ -283,6 +448,21 @@ void HandleKeys()
             if( pGame->KeyPressed(sf::Keyboard::M) ) state = MENU;
             break;
         }
+    case REPLAY:
+        {
+            //1 to 4 for x1, x2, x4 and x8, 0 to go to the end, M to stop
+            if( pGame->KeyPressed(sf::Keyboard::Num1) ) replaySpeed = 1;
+            if( pGame->KeyPressed(sf::Keyboard::Num2) ) replaySpeed = 2;
+            if( pGame->KeyPressed(sf::Keyboard::Num3) ) replaySpeed = 4;
+            if( pGame->KeyPressed(sf::Keyboard::Num4) ) replaySpeed = 8;
+            if( pGame->KeyPressed(sf::Keyboard::Num0) ) replaySpeed = 0;
+            if( pGame->KeyPressed(sf::Keyboard::M) )
+            {
+                player.Close();
+                state = MENU;
+            }
+            break;
+        }
     default:
         break;
     }
@@ -312,31 +492,26 @@ void SpriteDying(CSprite* pSprite)
 
 }
 
-void NewGame()
+//returns the seed of the pieces
+uint64 NewGame()
 {
-    score = 0;
-    dx = 0;
-    rotate = false;
-    colorNum = 1;
-    delay = 0.3;
-    //initialization for the first piece
-	a[0].x = 0, a[0].y = 1;
-    a[1].x = 1, a[1].y = 1;
-    a[2].x = 1, a[2].y = 2;
-    a[3].x = 1, a[3].y = 3;
-
-    for(int i=0;i<boardheight;i++)
-        for(int j=0;j<boardwidth;j++)
-            field[i][j] = 0;
+    input = IN_NONE;
+    bot.Reset();
+    inputQueue.Reset();
+
+    //the rules of the last replay don't stay
+    game.DefaultRules();
+    uint64 seed = std::chrono::steady_clock::now().time_since_epoch().count();
+    game.NewGame(seed);
+    return seed;
 }
 
-bool valid()
+bool StartReplay(const std::string &filename)
 {
-    //if out of bounds or the cells are occupied returns 0
-    for (int i=0;i<4;i++)
-      if (a[i].x<0 || a[i].x>=boardwidth || a[i].y>=boardheight) return false;
-      else if (field[a[i].y][a[i].x]) return false;
+    if( !player.Open(filename) ) return false;
 
+    player.ApplyRules(game);
+    game.NewGame(player.seed, player.gameid);
+    replaySpeed = 1;
     return true;
-};
-
+}
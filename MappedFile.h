@@ -0,0 +1,140 @@
+//read only file mapped in memory. the pages are only read from disk when they
+//are used, so opening a big file costs the same as opening a small one.
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    //general methods
+    bool Open(const std::string &filename, bool sequential = true);  //sequential if it's read from the start to the end
+    void Close();
+
+    //accessor methods
+    const unsigned char *GetData() { return data; };
+    size_t GetSize() { return size; };
+    bool IsOpen() { return data != nullptr; };
+
+private:
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+
+    //a mapping can't be copied
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+};
+
+MappedFile::MappedFile()
+{
+    data = nullptr;
+    size = 0;
+#ifdef _WIN32
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#else
+    fd = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &filename, bool sequential)
+{
+    Close();
+
+#ifdef _WIN32
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if( file == INVALID_HANDLE_VALUE ) return false;
+
+    LARGE_INTEGER filesize;
+    if( !GetFileSizeEx(file, &filesize) || filesize.QuadPart == 0 )
+    {
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if( mapping == nullptr )
+    {
+        Close();
+        return false;
+    }
+
+    data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if( data == nullptr )
+    {
+        Close();
+        return false;
+    }
+    size = (size_t)filesize.QuadPart;
+#else
+    fd = open(filename.c_str(), O_RDONLY);
+    if( fd < 0 ) return false;
+
+    struct stat st;
+    if( fstat(fd, &st) != 0 || st.st_size == 0 )
+    {
+        Close();
+        return false;
+    }
+
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if( p == MAP_FAILED )
+    {
+        Close();
+        return false;
+    }
+    data = (const unsigned char*)p;
+    size = st.st_size;
+
+    madvise(p, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if( data != nullptr ) UnmapViewOfFile(data);
+    if( mapping != nullptr ) CloseHandle(mapping);
+    if( file != INVALID_HANDLE_VALUE ) CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if( data != nullptr ) munmap((void*)data, size);
+    if( fd >= 0 ) close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+#endif
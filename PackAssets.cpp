@@ -0,0 +1,141 @@
+//asset packer. reads the asset list and writes all the files in one archive
+//that the game maps in memory instead of opening every file.
+//
+//usage: PackAssets [-d assetsdir] [-o archive]
+//  -d  folder with assets.txt and the img, snd, mus and fnt folders (default assets)
+//  -o  archive to write (default assets.pak)
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+#include "AssetArchive.h"
+
+//copies a string in a fixed size field, false if it doesn't fit with its ending zero
+bool SetField(char *field, size_t size, const std::string &str)
+{
+    if( str.size() >= size ) return false;
+    std::memset(field, 0, size);
+    std::memcpy(field, str.data(), str.size());
+    return true;
+}
+
+bool ReadFile(const std::string &filename, std::vector<char> &data)
+{
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if( !in.good() ) return false;
+    data.resize((size_t)in.tellg());
+    in.seekg(0);
+    in.read(data.data(), data.size());
+    return in.good();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = "assets";
+    std::string output = assetarchivefile;
+
+    for(int i=1;i<argc;i++)
+    {
+        std::string arg = argv[i];
+        if( arg == "-d" && i + 1 < argc ) dir = argv[++i];
+        else if( arg == "-o" && i + 1 < argc ) output = argv[++i];
+        else
+        {
+            std::cout << "usage: PackAssets [-d assetsdir] [-o archive]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    //the entries of the list
+    std::ifstream in(dir + "/assets.txt");
+    if( !in.good() )
+    {
+        std::cout << "Error opening " << dir << "/assets.txt" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<ArchiveEntry> entries;
+    std::vector<std::string> filenames;
+    std::string str;
+    while( std::getline(in,str) )
+    {
+        std::stringstream ss(str);
+        std::string datatype, name, filename, options;
+        ss>>datatype;
+        ss>>name;
+        ss>>filename;
+        ss>>options;
+        if( datatype.empty() ) continue;
+
+        ArchiveEntry e;
+        if( !SetField(e.datatype, sizeof(e.datatype), datatype) || !SetField(e.name, sizeof(e.name), name) ||
+            !SetField(e.options, sizeof(e.options), options) )
+        {
+            std::cout << "Error the names are too long: " << str << std::endl;
+            return EXIT_FAILURE;
+        }
+        e.offset = e.size = 0;
+        entries.push_back(e);
+        filenames.push_back(dir + "/" + datatype + "/" + filename);
+    }
+    in.close();
+
+    //the blobs go after the index, aligned
+    ArchiveHeader h;
+    std::memcpy(h.magic, "TPAK", 4);
+    h.version = archiveversion;
+    h.count = entries.size();
+    h.alignment = archivealignment;
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if( !out.good() )
+    {
+        std::cout << "Error creating " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //the index is written again at the end, when the offsets are known
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)entries.data(), entries.size() * sizeof(ArchiveEntry));
+
+    unsigned long long pos = sizeof(h) + entries.size() * sizeof(ArchiveEntry);
+    std::vector<char> zeros(archivealignment, 0);
+    std::vector<char> data;
+    for(size_t i=0;i<entries.size();i++)
+    {
+        if( !ReadFile(filenames[i], data) )
+        {
+            std::cout << "Error reading " << filenames[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        //zeros up to the alignment
+        unsigned long long padding = (archivealignment - pos % archivealignment) % archivealignment;
+        out.write(zeros.data(), padding);
+        pos += padding;
+
+        entries[i].offset = pos;
+        entries[i].size = data.size();
+        out.write(data.data(), data.size());
+        pos += data.size();
+
+        std::cout << entries[i].datatype << " " << entries[i].name << " " << data.size() << " bytes" << std::endl;
+    }
+
+    out.seekp(0);
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)entries.data(), entries.size() * sizeof(ArchiveEntry));
+    out.close();
+    if( !out.good() )
+    {
+        std::cout << "Error writing " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << output << ": " << entries.size() << " assets, " << pos << " bytes" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+//piece generator. the random numbers come from a counter based generator
+//(Widynski's squares): the n-th number is a pure function of a key and n, so
+//the pieces of a game only depend on (seed, gameid) and a generator is a few
+//bytes that can be copied and used by any thread without sharing anything.
+#ifndef PIECEGEN_H
+#define PIECEGEN_H
+
+typedef unsigned long long uint64;
+
+//mixes a 64 bit value, used to make keys from seeds (splitmix64 finalizer)
+inline uint64 MixBits(uint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+//key for the squares generator, it must be odd and not have runs of zeros
+inline uint64 MakeSquaresKey(uint64 seed, uint64 stream)
+{
+    uint64 key = MixBits(seed + 0x9e3779b97f4a7c15ULL * (stream + 1));
+    key |= 0x0101010101010101ULL; //no zero bytes
+    return key | 1;
+}
+
+//32 random bits for counter ctr
+inline unsigned int Squares32(uint64 ctr, uint64 key)
+{
+    uint64 x, y, z;
+    y = x = ctr * key;
+    z = y + key;
+    x = x * x + y; x = (x >> 32) | (x << 32);
+    x = x * x + z; x = (x >> 32) | (x << 32);
+    x = x * x + y; x = (x >> 32) | (x << 32);
+    return (unsigned int)((x * x + z) >> 32);
+}
+
+//random number in [0, n) from 32 random bits, without a division
+inline unsigned int RandomBelow(unsigned int bits, unsigned int n)
+{
+    return (unsigned int)(((uint64)bits * n) >> 32);
+}
+
+const int maxpreview = 8;
+
+//a new piece, the figure and the color it's drawn with
+struct NextPiece{
+    unsigned char figure;
+    unsigned char color;
+};
+
+class PieceGenerator
+{
+public:
+    PieceGenerator() { Reset(0, 0, false); };
+
+    //general methods
+    void Reset(uint64 seed, uint64 gameid, bool bag);
+    NextPiece Next();  //takes the first piece of the queue
+    NextPiece Peek(int i) const { return queue[(head + i) % maxpreview]; };  //i < maxpreview
+
+    //accessor methods
+    bool GetBag() const { return bag; };
+    uint64 GetCounter() const { return counter; };
+
+private:
+    uint64 key;
+    uint64 counter;
+    bool bag;  //7-bag mode: every 7 pieces have one of each figure
+
+    unsigned char bagPieces[7];
+    int bagPos;
+
+    //upcoming pieces, always full
+    NextPiece queue[maxpreview];
+    int head;
+
+    unsigned int Random() { return Squares32(counter++, key); };
+    NextPiece Generate();
+};
+
+void PieceGenerator::Reset(uint64 seed, uint64 gameid, bool pbag)
+{
+    key = MakeSquaresKey(seed, gameid);
+    counter = 0;
+    bag = pbag;
+    bagPos = 7;
+    head = 0;
+    for(int i=0;i<maxpreview;i++) queue[i] = Generate();
+}
+
+NextPiece PieceGenerator::Next()
+{
+    NextPiece p = queue[head];
+    queue[head] = Generate();
+    head = (head + 1) % maxpreview;
+    return p;
+}
+
+NextPiece PieceGenerator::Generate()
+{
+    NextPiece p;
+    p.color = 1 + RandomBelow(Random(), 7);
+
+    if( !bag )
+    {
+        p.figure = RandomBelow(Random(), 7);
+        return p;
+    }
+
+    //new shuffled bag when it's empty
+    if( bagPos >= 7 )
+    {
+        for(int i=0;i<7;i++) bagPieces[i] = i;
+        for(int i=6;i>0;i--)
+        {
+            int j = RandomBelow(Random(), i + 1);
+            unsigned char t = bagPieces[i];
+            bagPieces[i] = bagPieces[j];
+            bagPieces[j] = t;
+        }
+        bagPos = 0;
+    }
+    p.figure = bagPieces[bagPos++];
+    return p;
+}
+
+#endif
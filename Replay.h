@@ -0,0 +1,221 @@
+//replays. a replay is the seed and the rules of a game and the input of every
+//tick, so the game can be played again exactly the same.
+//
+//file format, every number is a varint (7 bits per byte, low bits first):
+//  "TRPL" version seed gameid bag gravityTicks softDropTicks rotationKicks
+//  then runs of ticks with the same input: length input ... and a 0 length at the end.
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <fstream>
+#include <string>
+
+#include "GameState.h"
+#include "MappedFile.h"
+
+const unsigned char replayversion = 2;
+
+class ReplayWriter
+{
+public:
+    ReplayWriter() { run = 0; input = 0; ticks = 0; };
+    ~ReplayWriter() { Close(); };
+
+    //general methods
+    bool Open(const std::string &filename, uint64 seed, uint64 gameid, const GameState &g);
+    void Record(unsigned int tickinput);  //call once per tick with the input given to Step
+    void Close();
+
+    //accessor methods
+    bool IsOpen() { return out.is_open(); };
+    unsigned long long GetTicks() { return ticks; };
+
+private:
+    std::ofstream out;
+    unsigned long long run;
+    unsigned int input;
+    unsigned long long ticks;
+
+    void WriteVarint(unsigned long long v);
+};
+
+class ReplayReader
+{
+public:
+    //what the replay was recorded with
+    uint64 seed;
+    uint64 gameid;
+    bool bag;
+    int gravityTicks;
+    int softDropTicks;
+    int rotationKicks;
+
+    ReplayReader() { pos = 0; run = 0; input = 0; };
+
+    //general methods
+    bool Open(const std::string &filename);
+    bool Next(unsigned int &tickinput);  //input of the next tick, false at the end
+    void ApplyRules(GameState &g);
+    void Close() { file.Close(); pos = 0; run = 0; };
+
+    //accessor methods
+    bool IsOpen() { return file.IsOpen(); };
+
+private:
+    MappedFile file;
+    size_t pos;
+    unsigned long long run;
+    unsigned int input;
+
+    bool ReadVarint(unsigned long long &v);
+};
+
+//-----------------------------------------------------------------
+// ReplayWriter
+//-----------------------------------------------------------------
+bool ReplayWriter::Open(const std::string &filename, uint64 seed, uint64 gameid, const GameState &g)
+{
+    Close();
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    if( !out.good() ) return false;
+
+    run = 0;
+    input = 0;
+    ticks = 0;
+
+    out.write("TRPL", 4);
+    WriteVarint(replayversion);
+    WriteVarint(seed);
+    WriteVarint(gameid);
+    WriteVarint(g.bag);
+    WriteVarint(g.gravityTicks);
+    WriteVarint(g.softDropTicks);
+    WriteVarint(g.rotationKicks);
+    return true;
+}
+
+void ReplayWriter::Record(unsigned int tickinput)
+{
+    if( !out.is_open() ) return;
+    ticks++;
+
+    //only the changes of input are written
+    if( run > 0 && tickinput == input )
+    {
+        run++;
+        return;
+    }
+    if( run > 0 )
+    {
+        WriteVarint(run);
+        WriteVarint(input);
+    }
+    input = tickinput;
+    run = 1;
+}
+
+void ReplayWriter::Close()
+{
+    if( !out.is_open() ) return;
+    if( run > 0 )
+    {
+        WriteVarint(run);
+        WriteVarint(input);
+    }
+    WriteVarint(0);
+    out.close();
+    run = 0;
+}
+
+void ReplayWriter::WriteVarint(unsigned long long v)
+{
+    unsigned char buf[10];
+    int n = 0;
+    while( v >= 0x80 )
+    {
+        buf[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (unsigned char)v;
+    out.write((const char*)buf, n);
+}
+
+//-----------------------------------------------------------------
+// ReplayReader
+//-----------------------------------------------------------------
+bool ReplayReader::Open(const std::string &filename)
+{
+    Close();
+    if( !file.Open(filename) ) return false;
+
+    const unsigned char *data = file.GetData();
+    if( file.GetSize() < 5 || data[0] != 'T' || data[1] != 'R' || data[2] != 'P' || data[3] != 'L' )
+    {
+        Close();
+        return false;
+    }
+    pos = 4;
+
+    unsigned long long version, vbag, vgravity, vsoft, vkicks;
+    if( !ReadVarint(version) || version != replayversion || !ReadVarint(seed) || !ReadVarint(gameid) ||
+        !ReadVarint(vbag) || !ReadVarint(vgravity) || !ReadVarint(vsoft) || !ReadVarint(vkicks) )
+    {
+        Close();
+        return false;
+    }
+
+    //rules the game can't run with are a broken file: no ticks per row would
+    //divide by zero and more kicks than the tables have don't exist
+    const unsigned long long maxticks = 1 << 16;
+    if( vgravity < 1 || vgravity > maxticks || vsoft < 1 || vsoft > maxticks || vkicks < 1 || vkicks > maxkicks )
+    {
+        Close();
+        return false;
+    }
+    bag = vbag != 0;
+    gravityTicks = (int)vgravity;
+    softDropTicks = (int)vsoft;
+    rotationKicks = (int)vkicks;
+    return true;
+}
+
+bool ReplayReader::Next(unsigned int &tickinput)
+{
+    if( run == 0 )
+    {
+        unsigned long long v;
+        if( !ReadVarint(run) || run == 0 || !ReadVarint(v) )
+        {
+            run = 0;
+            return false;
+        }
+        input = (unsigned int)v;
+    }
+    run--;
+    tickinput = input;
+    return true;
+}
+
+void ReplayReader::ApplyRules(GameState &g)
+{
+    g.bag = bag;
+    g.gravityTicks = gravityTicks;
+    g.softDropTicks = softDropTicks;
+    g.rotationKicks = rotationKicks;
+}
+
+bool ReplayReader::ReadVarint(unsigned long long &v)
+{
+    const unsigned char *data = file.GetData();
+    size_t size = file.GetSize();
+    v = 0;
+    for(int shift=0;shift<64 && pos<size;shift+=7)
+    {
+        unsigned char b = data[pos++];
+        v |= (unsigned long long)(b & 0x7F) << shift;
+        if( !(b & 0x80) ) return true;
+    }
+    return false;
+}
+
+#endif
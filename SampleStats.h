@@ -0,0 +1,48 @@
+//the last values of something measured, in milliseconds, and their
+//percentiles for the reports at the end
+#ifndef SAMPLESTATS_H
+#define SAMPLESTATS_H
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+class SampleStats
+{
+public:
+    static const int maxsamples = 1024;
+
+    SampleStats() { count = 0; };
+
+    //general methods
+    void Add(float ms) { samples[count++ % maxsamples] = ms; };  //the oldest one goes when it's full
+    void Reset() { count = 0; };
+    std::vector<float> Sorted();  //the ones kept, from the lowest
+
+    //accessor methods
+    int GetCount() { return std::min(count, maxsamples); };
+
+private:
+    float samples[maxsamples];
+    int count;
+};
+
+const int SampleStats::maxsamples;
+
+std::vector<float> SampleStats::Sorted()
+{
+    std::vector<float> v(samples, samples + GetCount());
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+//label p50 .. p90 .. p99 .. max .. of sorted values, nothing if there are none
+void PrintPercentiles(std::ostream &out, const char *label, const std::vector<float> &sorted)
+{
+    size_t n = sorted.size();
+    if( n == 0 ) return;
+    out << label << "p50 " << sorted[n / 2] << "  p90 " << sorted[n * 9 / 10]
+        << "  p99 " << sorted[n * 99 / 100] << "  max " << sorted[n - 1] << std::endl;
+}
+
+#endif
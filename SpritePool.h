@@ -0,0 +1,330 @@
+//sprite pool. many small sprites, like the pieces of an effect, kept as
+//columns instead of objects: every field of the sprites is an array, and
+//Update and Draw go through them in order. nothing is allocated per sprite,
+//the arrays keep their memory when sprites are removed.
+//
+//a sprite is known by a handle, its slot and the generation of the slot, so
+//a handle of a removed sprite is never taken for the one that comes after
+//it. killed sprites stay until the end of the next Update, then the last
+//ones are moved to their places. the drawing order by z is only sorted again
+//when sprites were added, removed or changed z.
+#ifndef SPRITEPOOL_H
+#define SPRITEPOOL_H
+
+#include <algorithm>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+struct SpriteHandle{
+    unsigned int slot;
+    unsigned int generation;  //0 is never used, the default handle is of no sprite
+
+    SpriteHandle() : slot(0), generation(0) {};
+    SpriteHandle(unsigned int pslot, unsigned int pgeneration) : slot(pslot), generation(pgeneration) {};
+};
+
+class SpritePool
+{
+public:
+    SpritePool() { orderDirty = false; };
+
+    //general methods
+    void Reserve(int n);
+    SpriteHandle Create(TextureHandle texture, sf::Vector2f pPosition, sf::Vector2f pVelocity, int iZOrder,
+        const sf::FloatRect &Bounds, BOUNDSACTION baBoundsAction = BA_STOP);
+    void Kill(SpriteHandle h);  //removed at the end of the next Update
+    void Update(sf::Time delta);
+    void Draw(sf::RenderTarget &target);
+    SpriteHandle HitTest(float x, float y);  //the top visible sprite at the point
+    void Clear();
+
+    //accessor methods, the handle must be alive
+    bool IsAlive(SpriteHandle h)
+        { return h.slot < slotGeneration.size() && slotGeneration[h.slot] == h.generation && !dying[slotIndex[h.slot]]; };
+    int GetCount() { return position.size(); };
+    sf::Vector2f GetPosition(SpriteHandle h) { return position[slotIndex[h.slot]]; };
+    void SetPosition(SpriteHandle h, sf::Vector2f vPosition) { position[slotIndex[h.slot]] = vPosition; };
+    sf::Vector2f GetVelocity(SpriteHandle h) { return velocity[slotIndex[h.slot]]; };
+    void SetVelocity(SpriteHandle h, sf::Vector2f vVelocity) { velocity[slotIndex[h.slot]] = vVelocity; };
+    int GetZOrder(SpriteHandle h) { return zOrder[slotIndex[h.slot]]; };
+    void SetZOrder(SpriteHandle h, int iZOrder);
+    void SetHidden(SpriteHandle h, bool bHidden) { hidden[slotIndex[h.slot]] = bHidden; };
+    void SetAnimation(SpriteHandle h, int inumFrames, int iframeDelay, bool boneCycle = false);
+
+private:
+    //the sprites, index i of every array is the same sprite
+    std::vector<sf::Vector2f> position;
+    std::vector<sf::Vector2f> velocity;
+    std::vector<sf::Vector2f> size;  //of one frame
+    std::vector<sf::FloatRect> bounds;
+    std::vector<unsigned char> boundsAction;
+    std::vector<int> zOrder;
+    std::vector<const sf::Texture*> texture;
+    std::vector<sf::IntRect> region;  //the image in the texture, the frames side by side
+    std::vector<int> numFrames, curFrame, frameDelay, frameTrigger;
+    std::vector<unsigned char> hidden, dying, oneCycle;
+    std::vector<unsigned int> slot;  //the slot of every sprite
+
+    //the slots of the handles
+    std::vector<unsigned int> slotIndex;  //the sprite of the slot
+    std::vector<unsigned int> slotGeneration;
+    std::vector<unsigned int> freeSlots;
+
+    std::vector<unsigned int> killed;  //sprites to remove
+    std::vector<unsigned int> order;  //the sprites by z
+    bool orderDirty;
+    sf::VertexArray vertices;  //4 per sprite, it only grows
+
+    void Remove(unsigned int i);
+    void FreeSlot(unsigned int s);
+    void SortOrder();
+};
+
+void SpritePool::Reserve(int n)
+{
+    position.reserve(n); velocity.reserve(n); size.reserve(n); bounds.reserve(n);
+    boundsAction.reserve(n); zOrder.reserve(n); texture.reserve(n); region.reserve(n);
+    numFrames.reserve(n); curFrame.reserve(n); frameDelay.reserve(n); frameTrigger.reserve(n);
+    hidden.reserve(n); dying.reserve(n); oneCycle.reserve(n); slot.reserve(n);
+    slotIndex.reserve(n); slotGeneration.reserve(n); freeSlots.reserve(n);
+    killed.reserve(n); order.reserve(n);
+    if( vertices.getVertexCount() < (size_t)n * 4 ) vertices.resize(n * 4);
+}
+
+SpriteHandle SpritePool::Create(TextureHandle ptexture, sf::Vector2f pPosition, sf::Vector2f pVelocity, int iZOrder,
+    const sf::FloatRect &Bounds, BOUNDSACTION baBoundsAction)
+{
+    TextureRegion *r = FindRegion(ptexture);
+    if( r == nullptr ) return SpriteHandle();
+
+    unsigned int s;
+    if( !freeSlots.empty() )
+    {
+        s = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        s = slotIndex.size();
+        slotIndex.push_back(0);
+        slotGeneration.push_back(1);
+    }
+    slotIndex[s] = position.size();
+
+    position.push_back(pPosition);
+    velocity.push_back(pVelocity);
+    size.push_back(sf::Vector2f(r->rect.width, r->rect.height));
+    bounds.push_back(Bounds);
+    boundsAction.push_back(baBoundsAction);
+    zOrder.push_back(iZOrder);
+    texture.push_back(r->texture);
+    region.push_back(r->rect);
+    numFrames.push_back(1);
+    curFrame.push_back(0);
+    frameDelay.push_back(0);
+    frameTrigger.push_back(0);
+    hidden.push_back(false);
+    dying.push_back(false);
+    oneCycle.push_back(false);
+    slot.push_back(s);
+
+    orderDirty = true;
+    return SpriteHandle(s, slotGeneration[s]);
+}
+
+void SpritePool::Kill(SpriteHandle h)
+{
+    if( !IsAlive(h) ) return;
+    unsigned int i = slotIndex[h.slot];
+    dying[i] = true;
+    killed.push_back(i);
+}
+
+void SpritePool::SetZOrder(SpriteHandle h, int iZOrder)
+{
+    unsigned int i = slotIndex[h.slot];
+    if( zOrder[i] == iZOrder ) return;
+    zOrder[i] = iZOrder;
+    orderDirty = true;
+}
+
+void SpritePool::SetAnimation(SpriteHandle h, int inumFrames, int iframeDelay, bool boneCycle)
+{
+    unsigned int i = slotIndex[h.slot];
+    numFrames[i] = std::max(inumFrames, 1);
+    frameDelay[i] = frameTrigger[i] = iframeDelay;
+    curFrame[i] = 0;
+    oneCycle[i] = boneCycle;
+    size[i].x = region[i].width / numFrames[i];
+}
+
+void SpritePool::Update(sf::Time delta)
+{
+    float dt = delta.asSeconds();
+    size_t n = position.size();
+
+    //the frames
+    for(size_t i=0;i<n;i++)
+    {
+        if( frameDelay[i] < 0 || --frameTrigger[i] > 0 ) continue;
+        frameTrigger[i] = frameDelay[i];
+        if( ++curFrame[i] < numFrames[i] ) continue;
+        curFrame[i] = 0;
+        if( oneCycle[i] && !dying[i] )
+        {
+            dying[i] = true;
+            killed.push_back(i);
+        }
+    }
+
+    //the positions, with the same bounds actions as CSprite
+    for(size_t i=0;i<n;i++)
+    {
+        sf::Vector2f p = position[i] + velocity[i] * dt;
+        const sf::FloatRect &b = bounds[i];
+        const sf::Vector2f &sz = size[i];
+
+        switch( boundsAction[i] )
+        {
+        case BA_WRAP:
+            if( p.x + sz.x < b.left ) p.x = b.left + b.width;
+            else if( p.x > b.left + b.width ) p.x = b.left - sz.x;
+            if( p.y + sz.y < b.top ) p.y = b.top + b.height;
+            else if( p.y > b.top + b.height ) p.y = b.top - sz.y;
+            break;
+        case BA_BOUNCE:
+            if( p.x < b.left ) { p.x = b.left; velocity[i].x = -velocity[i].x; }
+            else if( p.x + sz.x > b.left + b.width ) { p.x = b.left + b.width - sz.x; velocity[i].x = -velocity[i].x; }
+            if( p.y < b.top ) { p.y = b.top; velocity[i].y = -velocity[i].y; }
+            else if( p.y + sz.y > b.top + b.height ) { p.y = b.top + b.height - sz.y; velocity[i].y = -velocity[i].y; }
+            break;
+        case BA_DIE:
+            if( (p.x + sz.x < b.left || p.x > b.left + b.width || p.y + sz.y < b.top || p.y > b.top + b.height) && !dying[i] )
+            {
+                dying[i] = true;
+                killed.push_back(i);
+            }
+            break;
+        default:
+            if( p.x < b.left || p.x > b.left + b.width - sz.x )
+            {
+                p.x = std::max(b.left, std::min(p.x, b.left + b.width - sz.x));
+                velocity[i] = sf::Vector2f(0, 0);
+            }
+            if( p.y < b.top || p.y > b.top + b.height - sz.y )
+            {
+                p.y = std::max(b.top, std::min(p.y, b.top + b.height - sz.y));
+                velocity[i] = sf::Vector2f(0, 0);
+            }
+            break;
+        }
+        position[i] = p;
+    }
+
+    //the killed ones go away from the last to the first, so the ones moved to
+    //their places are never removed after being moved
+    if( killed.empty() ) return;
+    std::sort(killed.begin(), killed.end());
+    for(size_t k=killed.size();k-->0;) Remove(killed[k]);
+    killed.clear();
+    orderDirty = true;
+}
+
+//the last sprite takes the place of i
+void SpritePool::Remove(unsigned int i)
+{
+    unsigned int last = position.size() - 1;
+    FreeSlot(slot[i]);
+    if( i != last )
+    {
+        position[i] = position[last]; velocity[i] = velocity[last]; size[i] = size[last];
+        bounds[i] = bounds[last]; boundsAction[i] = boundsAction[last]; zOrder[i] = zOrder[last];
+        texture[i] = texture[last]; region[i] = region[last];
+        numFrames[i] = numFrames[last]; curFrame[i] = curFrame[last];
+        frameDelay[i] = frameDelay[last]; frameTrigger[i] = frameTrigger[last];
+        hidden[i] = hidden[last]; dying[i] = dying[last]; oneCycle[i] = oneCycle[last];
+        slot[i] = slot[last];
+        slotIndex[slot[i]] = i;
+    }
+    position.pop_back(); velocity.pop_back(); size.pop_back();
+    bounds.pop_back(); boundsAction.pop_back(); zOrder.pop_back();
+    texture.pop_back(); region.pop_back();
+    numFrames.pop_back(); curFrame.pop_back(); frameDelay.pop_back(); frameTrigger.pop_back();
+    hidden.pop_back(); dying.pop_back(); oneCycle.pop_back();
+    slot.pop_back();
+}
+
+//the handles of the slot's old sprite stop working
+void SpritePool::FreeSlot(unsigned int s)
+{
+    slotGeneration[s]++;
+    if( slotGeneration[s] == 0 ) slotGeneration[s] = 1;  //it went round
+    freeSlots.push_back(s);
+}
+
+//from the lowest z, the sprites with the same z stay in the order they are in the arrays
+void SpritePool::SortOrder()
+{
+    order.resize(position.size());
+    for(size_t i=0;i<order.size();i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return zOrder[a] < zOrder[b]; });
+    orderDirty = false;
+}
+
+void SpritePool::Draw(sf::RenderTarget &target)
+{
+    if( orderDirty ) SortOrder();
+
+    //the quads are written in place, and every run of the same texture is drawn at once
+    if( vertices.getVertexCount() < order.size() * 4 ) vertices.resize(order.size() * 4);
+    const sf::Texture *current = nullptr;
+    size_t first = 0, count = 0;
+    for(size_t k=0;k<order.size();k++)
+    {
+        unsigned int i = order[k];
+        if( hidden[i] ) continue;
+        if( texture[i] != current )
+        {
+            if( count > first ) target.draw(&vertices[first], count - first, sf::Quads, sf::RenderStates(current));
+            first = count;
+            current = texture[i];
+        }
+
+        float x = position[i].x, y = position[i].y, w = size[i].x, h = size[i].y;
+        float tx = region[i].left + w * curFrame[i], ty = region[i].top;
+        sf::Vertex *quad = &vertices[count];
+        quad[0] = sf::Vertex(sf::Vector2f(x, y), sf::Vector2f(tx, ty));
+        quad[1] = sf::Vertex(sf::Vector2f(x + w, y), sf::Vector2f(tx + w, ty));
+        quad[2] = sf::Vertex(sf::Vector2f(x + w, y + h), sf::Vector2f(tx + w, ty + h));
+        quad[3] = sf::Vertex(sf::Vector2f(x, y + h), sf::Vector2f(tx, ty + h));
+        count += 4;
+    }
+    if( count > first ) target.draw(&vertices[first], count - first, sf::Quads, sf::RenderStates(current));
+}
+
+SpriteHandle SpritePool::HitTest(float x, float y)
+{
+    if( orderDirty ) SortOrder();
+    for(size_t k=order.size();k-->0;)
+    {
+        unsigned int i = order[k];
+        if( hidden[i] || dying[i] ) continue;
+        if( sf::FloatRect(position[i], size[i]).contains(x, y) ) return SpriteHandle(slot[i], slotGeneration[slot[i]]);
+    }
+    return SpriteHandle();
+}
+
+void SpritePool::Clear()
+{
+    for(size_t i=0;i<slot.size();i++) FreeSlot(slot[i]);
+    position.clear(); velocity.clear(); size.clear(); bounds.clear();
+    boundsAction.clear(); zOrder.clear(); texture.clear(); region.clear();
+    numFrames.clear(); curFrame.clear(); frameDelay.clear(); frameTrigger.clear();
+    hidden.clear(); dying.clear(); oneCycle.clear(); slot.clear();
+    killed.clear();
+    order.clear();
+    orderDirty = false;
+}
+
+#endif
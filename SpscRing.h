@@ -0,0 +1,56 @@
+//single producer single consumer ring. one thread pushes and another one
+//pops without locks: each index is only written by its own side, and the
+//release/acquire pair makes the element visible before the index that says
+//it's there.
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "CacheLine.h"
+
+//size must be a power of 2, one place is always empty
+template<class T, size_t size> class SpscRing
+{
+    static_assert(size >= 2 && (size & (size - 1)) == 0, "the size of the ring is a power of 2");
+
+public:
+    SpscRing() { head.value = 0; tail.value = 0; };
+
+    //general methods
+    bool Push(const T &item);  //producer, false if it's full
+    bool Pop(T &item);         //consumer, false if it's empty
+
+    //accessor methods
+    bool IsEmpty() const { return head.value.load(std::memory_order_acquire) == tail.value.load(std::memory_order_acquire); };
+
+private:
+    //each thread writes its own index without taking the other one's line
+    T items[size];
+    CacheLinePadded<std::atomic<size_t>> head;  //next to pop, written by the consumer
+    CacheLinePadded<std::atomic<size_t>> tail;  //next to push, written by the producer
+};
+
+template<class T, size_t size> bool SpscRing<T, size>::Push(const T &item)
+{
+    size_t t = tail.value.load(std::memory_order_relaxed);
+    size_t next = (t + 1) & (size - 1);
+    if( next == head.value.load(std::memory_order_acquire) ) return false;
+
+    items[t] = item;
+    tail.value.store(next, std::memory_order_release);
+    return true;
+}
+
+template<class T, size_t size> bool SpscRing<T, size>::Pop(T &item)
+{
+    size_t h = head.value.load(std::memory_order_relaxed);
+    if( h == tail.value.load(std::memory_order_acquire) ) return false;
+
+    item = items[h];
+    head.value.store((h + 1) & (size - 1), std::memory_order_release);
+    return true;
+}
+
+#endif
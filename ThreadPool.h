@@ -0,0 +1,160 @@
+//work stealing thread pool. every worker has its own queue of tasks, it takes
+//them from the back of its queue and when it's empty it steals from the front
+//of the queues of the other workers.
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    //a task receives the index of the worker that runs it, so it can use
+    //data that belongs to that worker without locks.
+    typedef std::function<void(int)> Task;
+
+    ThreadPool(int numThreads = 0);  //0 uses all the cores
+    ~ThreadPool();
+
+    //general methods
+    void Submit(Task task);
+    void Wait();  //blocks until every submitted task is done
+
+    //accessor methods
+    int GetNumThreads() { return (int)workers.size(); };
+
+private:
+    struct WorkQueue{
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::mutex m;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+    std::atomic<int> queued;  //tasks waiting in the queues
+    std::atomic<int> pending;  //tasks submitted and not finished
+    unsigned int next;
+    bool stop;
+
+    void WorkerLoop(int index);
+    bool PopTask(int index, Task &task);
+};
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if( numThreads <= 0 ) numThreads = std::thread::hardware_concurrency();
+    if( numThreads <= 0 ) numThreads = 1;
+
+    queued = 0;
+    pending = 0;
+    next = 0;
+    stop = false;
+
+    for(int i=0;i<numThreads;i++)
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    for(int i=0;i<numThreads;i++)
+        workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stop = true;
+    }
+    cvWork.notify_all();
+    for(size_t i=0;i<workers.size();i++) workers[i].join();
+}
+
+void ThreadPool::Submit(Task task)
+{
+    pending++;
+
+    //the tasks are given round robin, the idle workers steal the rest
+    WorkQueue &q = *queues[next++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.m);
+        q.tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        queued++;
+    }
+    cvWork.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(m);
+    cvDone.wait(lock, [this]{ return pending == 0; });
+}
+
+bool ThreadPool::PopTask(int index, Task &task)
+{
+    //own queue first, newest task
+    {
+        WorkQueue &q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.m);
+        if( !q.tasks.empty() )
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    //steal the oldest task of another worker
+    for(size_t i=1;i<queues.size();i++)
+    {
+        WorkQueue &q = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.m);
+        if( !q.tasks.empty() )
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+    Task task;
+    while( true )
+    {
+        if( PopTask(index, task) )
+        {
+            task(index);
+            task = nullptr;
+
+            if( --pending == 0 )
+            {
+                std::lock_guard<std::mutex> lock(m);
+                cvDone.notify_all();
+            }
+            continue;
+        }
+
+        //nothing to do, sleep until there is more work
+        std::unique_lock<std::mutex> lock(m);
+        cvWork.wait(lock, [this]{ return stop || queued > 0; });
+        if( stop && queued == 0 ) return;
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+//triple buffer. one thread writes a new copy of something while another one
+//reads the last complete copy, without locks and without waiting for each
+//other: the writer has its own slot, the reader has its own slot, and the
+//third one is swapped between them with one atomic exchange.
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+template<class T> class TripleBuffer
+{
+public:
+    TripleBuffer() : middle(1), back(2), front(0) {};
+
+    //writer
+    T &Back() { return slots[back]; };  //the slot to write the next copy in
+    void Publish() { back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index; };
+
+    //reader
+    const T &Read();  //the last published copy, the same one again if there's no newer one
+    bool HasNew() { return (middle.load(std::memory_order_relaxed) & fresh) != 0; };
+
+private:
+    static const int index = 3;  //the slot number in middle
+    static const int fresh = 4;  //middle was published and not read yet
+
+    T slots[3];
+    std::atomic<int> middle;
+    int back;   //only used by the writer
+    int front;  //only used by the reader
+};
+
+template<class T> const T &TripleBuffer<T>::Read()
+{
+    if( HasNew() ) front = middle.exchange(front, std::memory_order_acq_rel) & index;
+    return slots[front];
+}
+
+#endif